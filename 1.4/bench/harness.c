@@ -0,0 +1,219 @@
+/* harness.c: timing harness for the benchmark corpus */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/*
+* Compile from this directory as
+*    gcc -O2 harness.c -o harness
+* and run as
+*    ./harness [-n runs] [-s seed] [-m minitip] [-o setting] corpus/NAME.run ...
+* Each run file is executed runs times (default 5) by
+*    minitip -c- -T -R seed
+* with the same seed (default 1) every time, after the settings given
+* by -o, such as -o solver=builtin; -o can be repeated. The minitip
+* binary is ../minitip by default.
+*
+* The expected verdict of a check is given by a comment line
+*    # expect TRUE|FALSE|GE|LE|ERROR
+* before it; GE and LE stand for "only >= (<=) is true". Every check,
+* test and xcheck command in the file must print exactly one verdict or
+* error line. For each check the median and 95th percentile of its
+* wall clock time (the sum of the phases printed by -T), the median
+* number of simplex iterations, and the number of wrong verdicts are
+* printed. The exit value is 1 if there were wrong verdicts.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE	4096
+#define MAX_OPTS	16
+
+/* verdicts */
+#define V_NONE		0	/* missing */
+#define V_TRUE		1
+#define V_FALSE		2
+#define V_GE		3	/* only >= is true */
+#define V_LE		4	/* only <= is true */
+#define V_ERROR		5
+static const char *vname[]={"-","TRUE","FALSE","GE","LE","ERROR"};
+
+struct check_t {
+    int line;			/* line number in the run file */
+    char text[41];		/* the beginning of the command */
+    int expect;			/* expected verdict */
+    int *verdict;		/* verdict in each run */
+    double *ms;			/* wall clock time in each run */
+    long *iter;			/* iterations in each run */
+};
+
+static int runs=5;
+static unsigned seed=1;
+static const char *minitip="../minitip";
+static const char *opts[MAX_OPTS]; static int optno=0;
+
+/* the verdict named by s, -1 if none */
+static int verdict_by_name(const char *s)
+{int v;
+    for(v=V_TRUE;v<=V_ERROR;v++)
+        if(strncmp(s,vname[v],strlen(vname[v]))==0) return v;
+    return -1;
+}
+
+/* the verdict in a line printed by minitip, -1 if not a verdict */
+static int verdict_of_output(const char *s)
+{   if(strncmp(s,"ERROR",5)==0) return V_ERROR;
+    if(strncmp(s,"    ==> ",8)!=0) return -1;
+    s+=8;
+    if(strncmp(s,"TRUE",4)==0) return V_TRUE;
+    if(strstr(s,"only >=")) return V_GE;
+    if(strstr(s,"only <=")) return V_LE;
+    return V_FALSE;
+}
+
+static int is_check(const char *s)
+{   while(*s==' ') s++;
+    return strncmp(s,"check ",6)==0 || strncmp(s,"test ",5)==0 ||
+           strncmp(s,"xcheck ",7)==0;
+}
+
+/* read the checks of the run file; return their number, -1 on error */
+static int read_checks(const char *fname, struct check_t **checks)
+{FILE *f; char buf[MAX_LINE],*s; int n,max,line,expect,v;
+    if(!(f=fopen(fname,"r"))){
+        fprintf(stderr,"cannot open %s\n",fname); return -1;
+    }
+    n=0; max=16; line=0; expect=V_NONE;
+    *checks=malloc(max*sizeof(struct check_t));
+    while(*checks && fgets(buf,MAX_LINE,f)){
+        line++;
+        buf[strcspn(buf,"\r\n")]=0;
+        if(buf[0]=='#'){
+            for(s=buf+1;*s==' ';s++);
+            if(strncmp(s,"expect ",7)==0){
+                for(s+=7;*s==' ';s++);
+                if((v=verdict_by_name(s))<0){
+                    fprintf(stderr,"%s:%d: unknown verdict\n",fname,line);
+                    fclose(f); return -1;
+                }
+                expect=v;
+            }
+            continue;
+        }
+        if(!is_check(buf)) continue;
+        if(n==max){
+            max*=2; *checks=realloc(*checks,max*sizeof(struct check_t));
+            if(!*checks) break;
+        }
+        (*checks)[n].line=line;
+        memcpy((*checks)[n].text,buf,40); (*checks)[n].text[40]=0;
+        (*checks)[n].expect=expect; expect=V_NONE;
+        (*checks)[n].verdict=calloc(runs,sizeof(int));
+        (*checks)[n].ms=calloc(runs,sizeof(double));
+        (*checks)[n].iter=calloc(runs,sizeof(long));
+        if(!(*checks)[n].verdict || !(*checks)[n].ms || !(*checks)[n].iter) break;
+        n++;
+    }
+    fclose(f);
+    if(!*checks || (n>0 && !(*checks)[n-1].iter)){
+        fprintf(stderr,"out of memory\n"); return -1;
+    }
+    return n;
+}
+
+/* execute the run file once, store the results as run r */
+static int execute(const char *fname, int n, struct check_t *checks, int r)
+{char cmd[MAX_LINE],buf[MAX_LINE],*s; FILE *p; int i,k,v,len; double t,sum;
+    len=snprintf(cmd,MAX_LINE,"printf 'set save=no\\n");
+    for(i=0;i<optno;i++) len+=snprintf(cmd+len,MAX_LINE-len,"set %s\\n",opts[i]);
+    len+=snprintf(cmd+len,MAX_LINE-len,"run %s\\nquit\\n' | '%s' -c- -T -R %u",
+                  fname,minitip,seed);
+    if(len>=MAX_LINE || !(p=popen(cmd,"r"))){
+        fprintf(stderr,"cannot execute %s\n",minitip); return 1;
+    }
+    k=-1;
+    while(fgets(buf,MAX_LINE,p)){
+        if((v=verdict_of_output(buf))>=0){
+            if(++k<n) checks[k].verdict[r]=v;
+        } else if(k>=0 && k<n && strncmp(buf,"    var_no ",11)==0){
+            if((s=strstr(buf,"iterations "))) checks[k].iter[r]=atol(s+11);
+        } else if(k>=0 && k<n && strncmp(buf,"    wall ",9)==0){
+            char *e;
+            for(sum=0.0,s=buf+9;(t=strtod(s,&e)),e!=s;s=e) sum+=t;
+            checks[k].ms[r]=sum;
+        }
+    }
+    pclose(p);
+    if(k+1!=n) fprintf(stderr,"%s: %d checks, %d verdicts\n",fname,n,k+1);
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{double x=*(const double*)a, y=*(const double*)b;
+    return x<y ? -1 : x>y ? 1 : 0;
+}
+static int cmp_long(const void *a, const void *b)
+{long x=*(const long*)a, y=*(const long*)b;
+    return x<y ? -1 : x>y ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{int i,j,r,n,wrong,total_wrong,total_checks; struct check_t *checks;
+ double *ms,total_ms;
+    for(i=1;i<argc && argv[i][0]=='-';i++){
+        if(i+1>=argc) break;
+        switch(argv[i][1]){
+      case 'n': runs=atoi(argv[++i]); break;
+      case 's': seed=(unsigned)strtoul(argv[++i],NULL,10); break;
+      case 'm': minitip=argv[++i]; break;
+      case 'o': if(optno<MAX_OPTS) opts[optno++]=argv[++i]; break;
+      default:  i=argc; break;
+        }
+    }
+    if(i>=argc || runs<1){
+        fprintf(stderr,"usage: harness [-n runs] [-s seed] [-m minitip] [-o setting] file.run ...\n");
+        return 2;
+    }
+    ms=malloc(runs*sizeof(double));
+    if(!ms) return 2;
+    printf("%-24s %-40s %6s %10s %10s %10s %5s\n","file:line","check","expect",
+           "median(ms)","p95(ms)","iterations","wrong");
+    total_wrong=total_checks=0; total_ms=0.0;
+    for(;i<argc;i++){
+        if((n=read_checks(argv[i],&checks))<0) return 2;
+        for(r=0;r<runs;r++) if(execute(argv[i],n,checks,r)) return 2;
+        for(j=0;j<n;j++){
+            char where[200];
+            for(wrong=0,r=0;r<runs;r++){
+                ms[r]=checks[j].ms[r];
+                if(checks[j].expect!=V_NONE && checks[j].verdict[r]!=checks[j].expect)
+                    wrong++;
+            }
+            qsort(ms,runs,sizeof(double),cmp_double);
+            qsort(checks[j].iter,runs,sizeof(long),cmp_long);
+            snprintf(where,sizeof(where),"%s:%d",argv[i],checks[j].line);
+            printf("%-24s %-40s %6s %10.3f %10.3f %10ld %5d\n",where,
+                   checks[j].text,vname[checks[j].expect],ms[(runs-1)/2],
+                   ms[(19*runs+19)/20-1],checks[j].iter[(runs-1)/2],wrong);
+            total_ms+=ms[(runs-1)/2]; total_wrong+=wrong; total_checks++;
+            free(checks[j].verdict); free(checks[j].ms); free(checks[j].iter);
+        }
+        free(checks);
+    }
+    printf("%d checks, %d runs each, seed %u: total median %.3f ms, %d wrong verdicts\n",
+           total_checks,runs,seed,total_ms,total_wrong);
+    free(ms);
+    return total_wrong ? 1 : 0;
+}
+
+/* EOF */
@@ -0,0 +1,107 @@
+/* mklp_bench.c: time the construction of the Shannon LP */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/*
+* Compile from this directory as
+*    gcc -O3 -I.. mklp_bench.c ../lpsolver.c ../verify.c ../symmetry.c \
+*        ../simplex.c ../cache.c -lglpk -lm -lpthread -o mklp_bench
+* and run as
+*    ./mklp_bench [maxvar]
+* For each number of variables from 2 to maxvar (default 10) the LP
+* with all Shannon inequalities is built
+*    colwise:  one glp_set_mat_col() call for each column, and
+*    bulk:     a single glp_load_matrix() call (as make_skeleton() does)
+* and the average time in milliseconds is printed. The time to copy
+* the prebuilt skeleton, which is done at each check, is also shown.
+*/
+
+#include <time.h>
+#include "../mklp.c"
+
+/* symbols which are defined in other modules of minitip */
+minitip_THREAD struct entropy_expr_t entropy_expr;
+const char *get_idname(int i){ (void)i; return NULL; }
+void minitip_assert(const char *expr,const char *file, int line)
+{   fprintf(stderr,"Assertion failed: %s, file %s, line %d\n",expr,file,line);
+    exit(1);
+}
+
+static double now(void)
+{struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec*1000.0+ts.tv_nsec*1e-6;
+}
+
+/* set var_no, rows, cols as do_variable_assignment() does; make room
+   for a column in row_idx[], row_val[] as call_lp() does */
+static void set_size(int n)
+{   var_no=n; rows=(1<<n)-1;
+    shannon = n<3 ? 1 : n*(n-1)*(1<<(n-3));
+    cols = shannon+n;
+    if(!row_room(rows)){ fprintf(stderr,"out of memory\n"); exit(1); }
+}
+
+/* build the Shannon LP column by column */
+static void build_colwise(void)
+{int i,k,n;
+    for(i=0;i<=rows;i++) rowperm[i]=i;
+    perm_array(rows+1,rowperm);
+    P=glp_create_prob();
+    glp_add_cols(P,cols); glp_add_rows(P,rows);
+    for(i=0;i<=cols;i++)glp_set_obj_coef(P,i,0.0);
+    glp_set_obj_dir(P,GLP_MIN);
+    for(i=1;i<=rows;i++) glp_set_row_bnds(P,i,GLP_FX,0.0,0.0);
+    for(i=1;i<=cols;i++){
+        n=shannon_column(i-1,row_idx+1,row_val+1);
+        for(k=1;k<=n;k++) row_idx[k]=rowperm[row_idx[k]];
+        add_column(i,n,GLP_LO);
+    }
+}
+
+int main(int argc, char *argv[])
+{int n,maxvar,rep,r; double t,tcol,tbulk,tcopy; glp_prob *Q;
+    maxvar = argc>1 ? atoi(argv[1]) : 10;
+    if(maxvar<2) maxvar=2;
+    if(maxvar>16) maxvar=16;
+    glp_term_out(GLP_OFF);
+    lp_solver=lp_get_solver(0);
+    printf("vars     rows     cols  colwise(ms)  bulk(ms)  copy(ms)\n");
+    for(n=2;n<=maxvar;n++){
+        set_size(n);
+        rep = n<8 ? 200 : n<11 ? 20 : 2;
+        /* column by column */
+        rowperm=malloc((rows+1)*sizeof(int));
+        t=now();
+        for(r=0;r<rep;r++){ build_colwise(); glp_delete_prob(P); P=NULL; }
+        tcol=(now()-t)/rep;
+        free(rowperm);
+        /* bulk */
+        t=now();
+        for(r=0;r<rep;r++){ make_skeleton(); drop_skeleton(); }
+        tbulk=(now()-t)/rep;
+        /* copy the prebuilt skeleton */
+        make_skeleton();
+        t=now();
+        for(r=0;r<rep;r++){
+            Q=glp_create_prob();
+            glp_copy_prob(Q,skeleton[var_no].P,GLP_OFF);
+            glp_delete_prob(Q);
+        }
+        tcopy=(now()-t)/rep;
+        drop_skeleton();
+        printf("%4d %8d %8d %12.3f %9.3f %9.3f\n",n,rows,cols,tcol,tbulk,tcopy);
+    }
+    return 0;
+}
+
+/* EOF */
@@ -0,0 +1,74 @@
+/* parse_bench.c: time parsing long entropy expressions */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/*
+* Compile from this directory as
+*    gcc -O3 -I.. parse_bench.c ../libminitip.c ../parser.c ../mklp.c \
+*        ../lpsolver.c ../verify.c ../symmetry.c ../simplex.c ../cache.c \
+*        ../xassert.c -lglpk -lm -lpthread -o parse_bench
+* and run as
+*    ./parse_bench [maxterms]
+* For 500, 1000, 2000, ... terms up to maxterms (default 16000) an
+* expression  +c1*S1+c2*S2+...>=0  is generated where Si are random
+* subsets of 16 variables, and the average time of parsing it is
+* printed. The time per term should not grow with the length.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "libminitip.h"
+
+static double now(void)
+{struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+/* n terms over the variables a..p */
+static char *make_expr(int n)
+{char *expr,*p; int i,j,v;
+    expr=malloc(n*24+8); if(!expr) return NULL;
+    for(p=expr,i=0;i<n;i++){
+        p+=sprintf(p,"%+d",rand()%2 ? 1+rand()%9 : -1-rand()%9);
+        v=1+rand()%0xffff;
+        for(j=0;j<16;j++) if(v&(1<<j)) *p++='a'+j;
+    }
+    strcpy(p,">=0");
+    return expr;
+}
+
+int main(int argc, char *argv[])
+{minitip_ctx *ctx; char *expr; int n,maxterms,rep,r; double t;
+    maxterms=argc>1 ? atoi(argv[1]) : 16000;
+    ctx=minitip_new();
+    if(!ctx){ printf("cannot create the context\n"); return 1; }
+    printf("%8s %12s %12s\n","terms","ms/parse","us/term");
+    for(n=500;n<=maxterms;n= n==500 ? 1000 : 2*n){
+        expr=make_expr(n);
+        if(!expr){ printf("out of memory\n"); return 1; }
+        rep=2000000/n; if(rep<3) rep=3;
+        t=now();
+        for(r=0;r<rep;r++) if(minitip_parse(ctx,expr)!=MINITIP_TRUE){
+            printf("syntax error: %s\n",minitip_error(ctx,NULL)); return 1;
+        }
+        t=(now()-t)/rep;
+        printf("%8d %12.3f %12.3f\n",n,t*1e3,t*1e6/n);
+        free(expr);
+    }
+    minitip_free(ctx);
+    return 0;
+}
+
+/* EOF */
@@ -0,0 +1,118 @@
+/* splx_bench.c: the built-in simplex method against glpk */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/*
+* Compile from this directory as
+*    gcc -O3 -I.. splx_bench.c ../lpsolver.c ../verify.c ../symmetry.c \
+*        ../simplex.c ../cache.c -lglpk -lm -lpthread -o splx_bench
+* and run as
+*    ./splx_bench [minvar [maxvar]]
+* For each number of variables n from minvar to maxvar (default 4 and
+* 10) two goals are checked with the Shannon inequalities only:
+*    han:       sum_i H(N-i) >= (n-1) H(N)   (true)
+*    ingleton:  [a,b,c,d] >= 0 on the first four variables  (false)
+* The time in milliseconds is printed for glpk, which solves the LP
+* copied from the prebuilt skeleton, and for the built-in simplex method;
+* the time to build the skeleton is not included. A verdict differing
+* from the expected one is marked by '!'.
+*/
+
+#include <time.h>
+#include "../mklp.c"
+
+/* symbols which are defined in other modules of minitip */
+minitip_THREAD struct entropy_expr_t entropy_expr;
+const char *get_idname(int i){ (void)i; return NULL; }
+void minitip_assert(const char *expr,const char *file, int line)
+{   fprintf(stderr,"Assertion failed: %s, file %s, line %d\n",expr,file,line);
+    exit(1);
+}
+
+static double now(void)
+{struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec*1000.0+ts.tv_nsec*1e-6;
+}
+
+/* set var_no, rows, cols as do_variable_assignment() does */
+static void set_size(int n)
+{   var_no=n; rows=(1<<n)-1;
+    shannon = n<3 ? 1 : n*(n-1)*(1<<(n-3));
+    cols = shannon+n;
+}
+
+/* the goals as coefficients of subsets */
+static void han_goal(double *goal)
+{int i;
+    for(i=0;i<=rows;i++) goal[i]=0.0;
+    for(i=0;i<var_no;i++) goal[rows&~(1<<i)]=1.0;
+    goal[rows]=-(var_no-1);
+}
+static void ingleton_goal(double *goal)
+{int i;
+    for(i=0;i<=rows;i++) goal[i]=0.0;
+    /* (a,b|c)+(a,b|d)+(c,d)-(a,b); a=1,b=2,c=4,d=8 */
+    goal[5]+=1; goal[6]+=1; goal[7]-=1; goal[4]-=1;
+    goal[9]+=1; goal[10]+=1; goal[11]-=1; goal[8]-=1;
+    goal[4]+=1; goal[8]+=1; goal[12]-=1;
+    goal[1]-=1; goal[2]-=1; goal[3]+=1;
+}
+
+/* solve with glpk; the skeleton exists */
+static char *glpk_check(const double *goal)
+{int i,n; char *retval;
+    create_glp(0);
+    for(i=1,n=0;i<=rows;i++) if(goal[i]!=0.0){
+        n++; row_idx[n]=rowperm[i]; row_val[n]=goal[i];
+    }
+    add_goal(n);
+    init_glp_parameters(10000000,1000);
+    retval=invoke_lp();
+    release_glp();
+    return retval;
+}
+static char *builtin_check(const double *goal)
+{   return builtin_msg(splx_solve(var_no,0,NULL,goal,10000000,1000)); }
+
+static void run(const char *name, void (*make_goal)(double*), char *expected)
+{double *goal,t,tglpk,tbuiltin; char *r1,*r2;
+    goal=malloc((rows+1)*sizeof(double));
+    make_goal(goal);
+    t=now(); r1=glpk_check(goal); tglpk=now()-t;
+    t=now(); r2=builtin_check(goal); tbuiltin=now()-t;
+    printf("%4d %-9s %11.2f%c %11.2f%c %9d\n",var_no,name,
+        tglpk,r1==expected ? ' ' : '!',tbuiltin,r2==expected ? ' ' : '!',
+        splx_iterations);
+    free(goal);
+}
+
+int main(int argc, char *argv[])
+{int n,minvar,maxvar;
+    minvar = argc>1 ? atoi(argv[1]) : 4;
+    maxvar = argc>2 ? atoi(argv[2]) : 10;
+    if(minvar<4) minvar=4;
+    if(maxvar>SPLX_MAX_VARNO) maxvar=SPLX_MAX_VARNO;
+    glp_term_out(GLP_OFF);
+    lp_solver=lp_get_solver(0);
+    printf("vars goal        glpk(ms)  builtin(ms)  iterations\n");
+    for(n=minvar;n<=maxvar;n++){
+        set_size(n);
+        if(make_skeleton()){ fprintf(stderr,"out of memory\n"); return 1; }
+        run("han",han_goal,EXPR_TRUE);
+        run("ingleton",ingleton_goal,EXPR_FALSE);
+        drop_skeleton();
+    }
+    return 0;
+}
+
+/* EOF */
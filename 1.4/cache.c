@@ -0,0 +1,361 @@
+/* cache.c: cache of verdicts keyed by a canonical form of the problem */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "minitip.h"
+#include "cache.h"
+
+/*----------------------------------------------------------------*/
+/* The canonical form
+   vectors: 0 is the goal, 1..ncols are the constraint columns with
+   merged terms, without zeros, divided by the smallest absolute
+   coefficient. Empty columns are left out. */
+static minitip_THREAD struct {
+    int n;			/* number of vectors */
+    int *kind;			/* VEC_ below */
+    int *start;			/* vector j is start[j]..start[j+1]-1 */
+    int *set;			/* subsets */
+    double *coeff;		/* coefficients */
+    int *mset; double *mcoeff;	/* the vector mapped by pi */
+    char *buf; char **str;	/* the key of each vector */
+} cv;
+
+#define VEC_GOAL_GE	'>'
+#define VEC_GOAL_EQ	'='
+#define VEC_LO		'g'
+#define VEC_FREE	'f'
+
+static void cv_release(void)
+{   if(cv.kind) free(cv.kind);
+    if(cv.start) free(cv.start);
+    if(cv.set) free(cv.set);
+    if(cv.coeff) free(cv.coeff);
+    if(cv.mset) free(cv.mset);
+    if(cv.mcoeff) free(cv.mcoeff);
+    if(cv.buf) free(cv.buf);
+    if(cv.str) free(cv.str);
+    memset(&cv,0,sizeof(cv));
+}
+
+/* add the vector with n terms to cv; return 1 if it is zero */
+static int cv_add(int kind, int n, const int set[], const double coeff[])
+{int i,k,m,*s; double *c,min;
+    s=cv.set+cv.start[cv.n]; c=cv.coeff+cv.start[cv.n];
+    for(m=0,i=0;i<n;i++){ // merge terms with the same subset
+        for(k=0;k<m && s[k]!=set[i];k++);
+        if(k==m){ s[m]=set[i]; c[m]=0.0; m++; }
+        c[k] += coeff[i];
+    }
+    for(n=0,min=0.0,i=0;i<m;i++){ // drop zeros
+        if(c[i]==0.0) continue;
+        s[n]=s[i]; c[n]=c[i]; n++;
+        if(min==0.0 || fabs(c[i])<min) min=fabs(c[i]);
+    }
+    if(n==0 && kind!=VEC_GOAL_GE && kind!=VEC_GOAL_EQ) return 1;
+    for(i=0;i<n;i++) c[i] /= min;
+    cv.kind[cv.n]=kind;
+    cv.n++; cv.start[cv.n]=cv.start[cv.n-1]+n;
+    return 0;
+}
+
+/* image of the subset s under the permutation pi */
+static int map_set(int s, const int pi[])
+{int i,r;
+    for(r=0,i=0;s;i++,s>>=1) if(s&1) r|=1<<pi[i];
+    return r;
+}
+
+/* write vector j mapped by pi to out, return the number of chars */
+static int cv_write(int j, const int pi[], char *out)
+{int i,k,n,ts,len; int *s; double *c,tc;
+    s=cv.mset; c=cv.mcoeff; n=cv.start[j+1]-cv.start[j];
+    for(i=0;i<n;i++){ /* insertion sort by the mapped subset */
+        ts=map_set(cv.set[cv.start[j]+i],pi); tc=cv.coeff[cv.start[j]+i];
+        for(k=i;k>0 && s[k-1]>ts;k--){ s[k]=s[k-1]; c[k]=c[k-1]; }
+        s[k]=ts; c[k]=tc;
+    }
+    if(cv.kind[j]==VEC_FREE && n>0 && c[0]<0.0){
+        for(i=0;i<n;i++) c[i] = -c[i];
+    }
+    len=sprintf(out,"%c",cv.kind[j]);
+    for(i=0;i<n;i++)
+        len+=sprintf(out+len,"%s%d:%.17g",i ? "," : "",s[i],c[i]);
+    return len;
+}
+
+static int cmp_str(const void *a, const void *b)
+{   return strcmp(*(char *const*)a,*(char *const*)b); }
+
+/* write the problem mapped by pi to key */
+static void cv_key(int var_no, const int pi[], char *key)
+{int j,len; char *b;
+    len=sprintf(key,"%d",var_no);
+    len+=cv_write(0,pi,key+len);
+    for(b=cv.buf,j=1;j<cv.n;j++){
+        cv.str[j]=b; b+=cv_write(j,pi,b)+1;
+    }
+    qsort(cv.str+1,cv.n-1,sizeof(char*),cmp_str);
+    for(j=1;j<cv.n;j++){ // drop repeated columns
+        if(j>1 && strcmp(cv.str[j],cv.str[j-1])==0) continue;
+        len+=sprintf(key+len,"|%s",cv.str[j]);
+    }
+}
+
+/* an invariant of each variable: a hash of the terms containing it */
+static unsigned long long mix(unsigned long long x)
+{   x += 0x9e3779b97f4a7c15ULL;
+    x = (x^(x>>30))*0xbf58476d1ce4e5b9ULL;
+    x = (x^(x>>27))*0x94d049bb133111ebULL;
+    return x^(x>>31);
+}
+static void invariants(int var_no, unsigned long long sig[])
+{int i,j,k,n; unsigned long long h; double c;
+    for(k=0;k<var_no;k++) sig[k]=0;
+    for(j=0;j<cv.n;j++){
+        n=cv.start[j+1]-cv.start[j];
+        for(i=cv.start[j];i<cv.start[j+1];i++){
+            c=fabs(cv.coeff[i]);
+            memcpy(&h,&c,sizeof(h));
+            h=mix(h^mix((unsigned long long)(cv.kind[j]*64+n)
+                        ^((unsigned long long)__builtin_popcount(cv.set[i])<<32)));
+            for(k=0;k<var_no;k++) if(cv.set[i]&(1<<k)) sig[k]+=h;
+        }
+    }
+}
+
+/* next permutation of arr[0..n-1] in lexicographic order; if it was
+   the last one, sort arr and return 0 */
+static int next_perm(int n, int arr[])
+{int i,j,t,more;
+    for(i=n-2;i>=0 && arr[i]>arr[i+1];i--);
+    more = i>=0;
+    if(more){
+        for(j=n-1;arr[j]<arr[i];j--);
+        t=arr[i]; arr[i]=arr[j]; arr[j]=t;
+    }
+    for(i++,j=n-1;i<j;i++,j--){ t=arr[i]; arr[i]=arr[j]; arr[j]=t; }
+    return more;
+}
+
+char *cache_key(int var_no, int eq, int n, const int set[],
+        const double coeff[], int ncols, const struct cache_column_t col[])
+{int i,j,k,nterm,size,total,cls[32],ncls,order[32],pi[32]={0};
+ unsigned long long sig[32]; char *key,*best;
+    for(nterm=n,j=0;j<ncols;j++) nterm+=col[j].n;
+    memset(&cv,0,sizeof(cv));
+    cv.kind=malloc((ncols+1)*sizeof(int));
+    cv.start=malloc((ncols+2)*sizeof(int));
+    cv.set=malloc((nterm+1)*sizeof(int));
+    cv.coeff=malloc((nterm+1)*sizeof(double));
+    cv.mset=malloc((nterm+1)*sizeof(int));
+    cv.mcoeff=malloc((nterm+1)*sizeof(double));
+    size=40*nterm+4*ncols+32; // ,%d:%.17g is at most 35 chars
+    cv.buf=malloc(size);
+    cv.str=malloc((ncols+1)*sizeof(char*));
+    key=malloc(size); best=malloc(size);
+    if(!cv.kind || !cv.start || !cv.set || !cv.coeff || !cv.mset ||
+       !cv.mcoeff || !cv.buf || !cv.str || !key || !best){
+        cv_release();
+        if(key) free(key);
+        if(best) free(best);
+        return NULL;
+    }
+    cv.start[0]=0;
+    cv_add(eq ? VEC_GOAL_EQ : VEC_GOAL_GE,n,set,coeff);
+    for(j=0;j<ncols;j++)
+        cv_add(col[j].free ? VEC_FREE : VEC_LO,col[j].n,col[j].set,col[j].coeff);
+    /* sort variables by their invariants, ties by index */
+    invariants(var_no,sig);
+    for(i=0;i<var_no;i++){
+        for(k=i;k>0 && sig[order[k-1]]>sig[i];k--) order[k]=order[k-1];
+        order[k]=i;
+    }
+    /* cls[] are the starting positions of classes with equal invariant */
+    for(ncls=0,total=1,i=0;i<var_no;i++){
+        if(i==0 || sig[order[i]]!=sig[order[i-1]]) cls[ncls++]=i;
+        else if(total<=CACHE_MAX_PERM) total *= i-cls[ncls-1]+1;
+    }
+    cls[ncls]=var_no;
+    for(i=0;i<var_no;i++) pi[order[i]]=i;
+    cv_key(var_no,pi,best);
+    if(total>1 && total<=CACHE_MAX_PERM){
+        for(;;){
+            for(k=ncls-1;k>=0 && !next_perm(cls[k+1]-cls[k],order+cls[k]);k--);
+            if(k<0) break; // all orders were tried
+            for(i=0;i<var_no;i++) pi[order[i]]=i;
+            cv_key(var_no,pi,key);
+            if(strcmp(key,best)<0){ char *t=key; key=best; best=t; }
+        }
+    }
+    cv_release(); free(key);
+    return best;
+}
+
+/*----------------------------------------------------------------*/
+/* LRU cache: hash table of entries on a doubly linked list; the
+   most recently used entry is lru.next. The cache is shared by the
+   threads, the calls below hold cache_lock. */
+struct entry_t {
+    char *key;
+    unsigned hash;
+    int verdict;
+    struct entry_t *hnext;	/* next in the hash chain */
+    struct entry_t *prev,*next;	/* LRU list */
+};
+static struct entry_t lru={NULL,0,0,NULL,&lru,&lru};
+static struct entry_t **htab=NULL;
+static unsigned hmask=0;
+static int max_entries=10000;
+struct cache_stats_t cache_stats;
+static pthread_mutex_t cache_lock=PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned hash_key(const char *key)
+{unsigned h=2166136261u;
+    while(*key){ h^=(unsigned char)*key++; h*=16777619u; }
+    return h;
+}
+
+static void unlink_lru(struct entry_t *e)
+{   e->prev->next=e->next; e->next->prev=e->prev; }
+static void link_lru(struct entry_t *e)
+{   e->next=lru.next; e->prev=&lru; lru.next->prev=e; lru.next=e; }
+
+static struct entry_t *find(const char *key, unsigned h)
+{struct entry_t *e;
+    if(!htab) return NULL;
+    for(e=htab[h&hmask];e;e=e->hnext)
+        if(e->hash==h && strcmp(e->key,key)==0) return e;
+    return NULL;
+}
+
+static void drop_entry(struct entry_t *e)
+{struct entry_t **p;
+    for(p=&htab[e->hash&hmask];*p!=e;p=&(*p)->hnext);
+    *p=e->hnext;
+    unlink_lru(e);
+    free(e->key); free(e);
+    cache_stats.entries--;
+}
+
+/* double the hash table when it is full; return 1 if out of memory */
+static int grow_table(void)
+{struct entry_t **nt,*e; unsigned nmask;
+    if(htab && cache_stats.entries<(int)hmask) return 0;
+    nmask = htab ? 2*hmask+1 : 1023;
+    nt=calloc(nmask+1,sizeof(struct entry_t*));
+    if(!nt) return 1;
+    for(e=lru.next;e!=&lru;e=e->next){
+        e->hnext=nt[e->hash&nmask]; nt[e->hash&nmask]=e;
+    }
+    if(htab) free(htab);
+    htab=nt; hmask=nmask;
+    return 0;
+}
+
+int cache_lookup(const char *key)
+{struct entry_t *e; int verdict;
+    pthread_mutex_lock(&cache_lock);
+    if(!(e=find(key,hash_key(key)))){
+        cache_stats.misses++; verdict=0;
+    } else {
+        unlink_lru(e); link_lru(e);
+        cache_stats.hits++; verdict=e->verdict;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return verdict;
+}
+
+/* add or update an entry; return 1 if out of memory */
+static int put(const char *key, int verdict)
+{struct entry_t *e; unsigned h;
+    h=hash_key(key);
+    if((e=find(key,h))){
+        e->verdict=verdict; unlink_lru(e); link_lru(e);
+        return 0;
+    }
+    if(grow_table() || !(e=malloc(sizeof(struct entry_t)))) return 1;
+    if(!(e->key=strdup(key))){ free(e); return 1; }
+    e->hash=h; e->verdict=verdict;
+    e->hnext=htab[h&hmask]; htab[h&hmask]=e;
+    link_lru(e);
+    cache_stats.entries++;
+    while(cache_stats.entries>max_entries) drop_entry(lru.prev);
+    return 0;
+}
+
+void cache_store(const char *key, int verdict)
+{   pthread_mutex_lock(&cache_lock);
+    if(put(key,verdict)==0) cache_stats.changed=1;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void cache_limit(int size)
+{   pthread_mutex_lock(&cache_lock);
+    max_entries = size<1 ? 1 : size;
+    while(cache_stats.entries>max_entries) drop_entry(lru.prev);
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void cache_clear(void)
+{   pthread_mutex_lock(&cache_lock);
+    while(lru.next!=&lru) drop_entry(lru.next);
+    cache_stats.changed=0;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+/* The file has a header line, and one line for each entry in the form
+   <verdict> <key>, the most recently used last. */
+#define CACHE_HEADER	"# minitip result cache"
+
+int cache_load(const char *file)
+{FILE *f; char *line=NULL,*s; size_t len=0; int n,verdict;
+    if(!(f=fopen(file,"r"))) return -1;
+    n=0; pthread_mutex_lock(&cache_lock);
+    while(getline(&line,&len,f)>0){
+        if(line[0]=='#') continue;
+        line[strcspn(line,"\r\n")]=0;
+        verdict=(int)strtol(line,&s,10);
+        if(verdict<=0 || *s!=' ' || !s[1]) continue; // not an entry
+        if(put(s+1,verdict)) break;
+        n++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    if(line) free(line);
+    fclose(f);
+    return n;
+}
+
+int cache_save(const char *file)
+{FILE *f; char *tmp; struct entry_t *e; int err;
+    tmp=malloc(strlen(file)+5);
+    if(!tmp) return -1;
+    sprintf(tmp,"%s.tmp",file);
+    if(!(f=fopen(tmp,"w"))){ free(tmp); return -1; }
+    fprintf(f,CACHE_HEADER "\n");
+    pthread_mutex_lock(&cache_lock);
+    for(e=lru.prev;e!=&lru;e=e->prev) fprintf(f,"%d %s\n",e->verdict,e->key);
+    pthread_mutex_unlock(&cache_lock);
+    err=ferror(f); err|=fclose(f);
+    if(!err) err=rename(tmp,file);
+    if(err) remove(tmp);
+    free(tmp);
+    if(err) return -1;
+    cache_stats.changed=0;
+    return 0;
+}
+
+/* EOF */
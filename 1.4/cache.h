@@ -0,0 +1,91 @@
+/* cache.h: cache of verdicts keyed by a canonical form of the problem */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* A problem is the goal and the constraint columns after the variables
+* have been merged; subsets of the var_no final variables are bitmaps
+* 1 .. 2^var_no-1. The verdict does not change when the variables are
+* permuted, the goal or a column is multiplied by a positive number
+* (free columns by any nonzero number), or the columns are reordered
+* or repeated. The key is a string written from the problem after
+*   - merging terms with the same subset and dropping zeros,
+*   - dividing each vector by its smallest absolute coefficient,
+*   - relabelling the variables: they are sorted by an invariant
+*     computed from the terms containing them; variables with the same
+*     invariant are tried in all orders (at most CACHE_MAX_PERM of
+*     them), and the smallest string is taken,
+*   - sorting the columns and dropping repeated ones.
+* Coefficients are written with 17 significant digits, which is exact
+* for doubles.
+* Renamed problems get the same key unless there are too many ways to
+* order variables with the same invariant; different problems always
+* get different keys.
+*
+* struct cache_column_t
+*    a constraint column: n terms, set[i] is a subset, coeff[i] is its
+*    coefficient; free is set for free (=0) columns.
+* char *cache_key(int var_no, int eq, int n, const int set[],
+*        const double coeff[], int ncols, const struct cache_column_t col[])
+*    the key of the problem whose goal has n terms set[],coeff[]; eq is
+*    set if the goal is =0 rather than >=0. The key is malloc'ed;
+*    returns NULL if out of memory.
+*
+* The cache keeps the most recently used entries. Verdicts are small
+* positive integers chosen by the caller. The cache is shared by all
+* threads; the calls below are serialized by a lock.
+* int cache_lookup(const char *key)
+*    the verdict stored with key, or 0 if there is none.
+* void cache_store(const char *key, int verdict)
+*    store the verdict; the least recently used entry is dropped if
+*    the cache is full.
+* void cache_limit(int size)
+*    set the maximal number of entries.
+* int cache_load(const char *file)
+*    add the entries in file to the cache. Returns the number of
+*    entries read, or -1 if the file cannot be opened.
+* int cache_save(const char *file)
+*    write the cache to file; returns 0 if OK, -1 on error.
+* void cache_clear(void)
+*    drop all entries.
+* struct cache_stats_t cache_stats
+*    number of entries, hits, misses since the start, and whether the
+*    cache changed since it was loaded or saved.
+*/
+
+#define CACHE_MAX_PERM	720	/* variable orders tried */
+
+struct cache_column_t {
+    int free;			/* free column */
+    int n;			/* number of terms */
+    const int *set;		/* subsets */
+    const double *coeff;	/* coefficients */
+};
+
+char *cache_key(int var_no, int eq, int n, const int set[],
+        const double coeff[], int ncols, const struct cache_column_t col[]);
+
+int cache_lookup(const char *key);
+void cache_store(const char *key, int verdict);
+void cache_limit(int size);
+int cache_load(const char *file);
+int cache_save(const char *file);
+void cache_clear(void);
+
+struct cache_stats_t {
+    int entries;		/* entries in the cache */
+    long hits, misses;		/* lookups */
+    int changed;		/* not saved since the last change */
+};
+extern struct cache_stats_t cache_stats;
+
+/* EOF */
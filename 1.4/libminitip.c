@@ -0,0 +1,278 @@
+/* libminitip.c: minitip as a library */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "minitip.h"
+#include "parser.h"
+#include "mklp.h"
+#include "libminitip.h"
+
+/***********************************************************************
+* The context
+*   owner           the thread which created the context
+*   parser, lp      the saved state of the parser and the LP module
+*   opt             LP options
+*   constraint_no   number of constraints
+*   max_constraints size of the constraint array
+*   constraint[]    compiled constraints
+*   error, errpos   error message and syntax error position of the
+*                   last call
+*/
+struct minitip_ctx_t {
+    pthread_t owner;
+    struct parser_state_t *parser;
+    struct lp_state_t *lp;
+    struct lp_options_t opt;
+    int constraint_no, max_constraints;
+    struct constraint_t **constraint;
+    char error[200]; int errpos;
+};
+
+/***********************************************************************
+* Entering and leaving a context
+*   The parser and the LP module keep their state in thread local
+*   variables. A call swaps the state of the context into the calling
+*   thread and out when done, thus calls on different contexts run at
+*   the same time.
+*   int enter(ctx)
+*     swap in the state of ctx and clear the error. Returns 0 and sets
+*     the error if the calling thread is not the owner of ctx.
+*   void leave(ctx)
+*     swap out the state of ctx
+*   void set_error(ctx,err,pos)
+*     store the error message of the call
+*   void syntax_err(ctx)
+*     store the error in syntax_error
+*/
+static void set_error(minitip_ctx *ctx, const char *err, int pos);
+
+static int enter(minitip_ctx *ctx)
+{   if(!pthread_equal(ctx->owner,pthread_self())){
+        set_error(ctx,"the context is used by another thread",-1);
+        return 0;
+    }
+    parser_state_swap(ctx->parser); lp_state_swap(ctx->lp);
+    ctx->error[0]=0; ctx->errpos=-1;
+    return 1;
+}
+static void leave(minitip_ctx *ctx)
+{   lp_state_swap(ctx->lp); parser_state_swap(ctx->parser); }
+static void set_error(minitip_ctx *ctx, const char *err, int pos)
+{   strncpy(ctx->error,err ? err : "",sizeof(ctx->error)-1);
+    ctx->error[sizeof(ctx->error)-1]=0; ctx->errpos=pos;
+}
+static void syntax_err(minitip_ctx *ctx)
+{   if(syntax_error.harderrstr)
+        set_error(ctx,syntax_error.harderrstr,syntax_error.harderrpos);
+    else
+        set_error(ctx,syntax_error.softerrstr,syntax_error.softerrpos);
+}
+
+/***********************************************************************
+* Creating and releasing a context
+*/
+minitip_ctx *minitip_new(void)
+{minitip_ctx *ctx; int measures;
+    ctx=calloc(1,sizeof(minitip_ctx));
+    if(!ctx) return NULL;
+    ctx->owner=pthread_self();
+    ctx->parser=parser_state_new(); ctx->lp=lp_state_new();
+    ctx->max_constraints=minitip_INITIAL_CONSTR;
+    ctx->constraint=malloc(ctx->max_constraints*sizeof(struct constraint_t *));
+    if(!ctx->parser || !ctx->lp || !ctx->constraint){
+        minitip_free(ctx); return NULL;
+    }
+    ctx->opt.solver=0; ctx->opt.iterlimit=minitip_ITERLIMIT;
+    ctx->opt.timelimit=minitip_TIMELIMIT;
+    ctx->opt.portfolio=1; ctx->opt.consensus=1;
+    ctx->opt.lazy=LAZY_AUTO_VARNO; ctx->opt.formulation=LP_PRIMAL;
+    enter(ctx);
+    resize_macro_table(minitip_INITIAL_MACRONO);
+    measures=parse_standard_macros();
+    if(measures>=0){
+        set_syntax_style(minitip_INITIAL_STYLE,minitip_INITIAL_SEPCHAR,1);
+        set_syntax_measure(1,measures,macro_total);
+    }
+    leave(ctx);
+    if(measures<0){ minitip_free(ctx); return NULL; }
+    return ctx;
+}
+
+void minitip_free(minitip_ctx *ctx)
+{int i;
+    if(!ctx) return;
+    for(i=0;i<ctx->constraint_no;i++) free_constraint(ctx->constraint[i]);
+    if(ctx->constraint) free(ctx->constraint);
+    lp_state_free(ctx->lp);
+    parser_state_free(ctx->parser);
+    free(ctx);
+}
+
+void minitip_thread_end(void)
+{   parser_release_buffers(); lp_release_buffers(); }
+
+struct lp_options_t *minitip_options(minitip_ctx *ctx)
+{   return &ctx->opt; }
+
+const struct lp_stats_t *minitip_stats(minitip_ctx *ctx)
+{   return lp_state_stats(ctx->lp); }
+
+/* constraints are bound to variable names parsed in the old style,
+   thus they are deleted */
+void minitip_set_style(minitip_ctx *ctx, int full, char sepchar)
+{   if(minitip_del(ctx,-1)!=MINITIP_TRUE) return;
+    enter(ctx);
+    if(full) set_syntax_style(syntax_full,';',1);
+    else set_syntax_style(syntax_short,sepchar,1);
+    leave(ctx);
+}
+
+const char *minitip_error(minitip_ctx *ctx, int *pos)
+{   if(pos) *pos=ctx->errpos;
+    return ctx->error;
+}
+
+/***********************************************************************
+* Parsing, macros, constraints
+*/
+int minitip_parse(minitip_ctx *ctx, const char *expr)
+{int ret;
+    if(!enter(ctx)) return MINITIP_ERROR;
+    ret=parse_entropy(expr,0)==PARSE_ERR ? MINITIP_SYNTAX : MINITIP_TRUE;
+    if(ret==MINITIP_SYNTAX) syntax_err(ctx);
+    leave(ctx);
+    return ret;
+}
+
+int minitip_macro(minitip_ctx *ctx, const char *def)
+{int ret;
+    if(!enter(ctx)) return MINITIP_ERROR;
+    resize_macro_table(macro_total+minitip_INITIAL_MACRONO);
+    ret=parse_macro_definition(def)==PARSE_OK ? MINITIP_TRUE : MINITIP_SYNTAX;
+    if(ret==MINITIP_SYNTAX) syntax_err(ctx);
+    leave(ctx);
+    return ret;
+}
+
+int minitip_add(minitip_ctx *ctx, const char *constr)
+{int ret; struct constraint_t *c,**table; const char *err;
+    if(!enter(ctx)) return MINITIP_ERROR;
+    if(ctx->constraint_no>=ctx->max_constraints){
+        table=realloc(ctx->constraint,
+              2*ctx->max_constraints*sizeof(struct constraint_t *));
+        if(table){ ctx->constraint=table; ctx->max_constraints*=2; }
+    }
+    ret=minitip_compile_constraint(constr,&c,&err);
+    if(ret==MINITIP_SYNTAX){
+        syntax_err(ctx);
+    } else if(ret==MINITIP_TRUE && ctx->constraint_no>=ctx->max_constraints){
+        free_constraint(c);
+        set_error(ctx,"out of memory while storing this constraint",-1);
+        ret=MINITIP_ERROR;
+    } else if(ret==MINITIP_TRUE){
+        ctx->constraint[ctx->constraint_no]=c; ctx->constraint_no++;
+        invalidate_lp();
+    } else {
+        set_error(ctx,err,-1);
+    }
+    leave(ctx);
+    return ret;
+}
+
+int minitip_del(minitip_ctx *ctx, int idx)
+{int i;
+    if(idx>=ctx->constraint_no){
+        set_error(ctx,"no such constraint",-1); return MINITIP_ERROR;
+    }
+    if(!enter(ctx)) return MINITIP_ERROR;
+    if(idx<0){
+        for(i=0;i<ctx->constraint_no;i++) free_constraint(ctx->constraint[i]);
+        ctx->constraint_no=0;
+    } else {
+        free_constraint(ctx->constraint[idx]);
+        ctx->constraint_no--;
+        for(i=idx;i<ctx->constraint_no;i++)
+            ctx->constraint[i]=ctx->constraint[i+1];
+    }
+    invalidate_lp();
+    leave(ctx);
+    return MINITIP_TRUE;
+}
+
+/***********************************************************************
+* Compiling constraints and checking on the state as it is
+*/
+int minitip_compile_constraint(const char *constr, struct constraint_t **c,
+        const char **err)
+{   *err=""; *c=NULL;
+    if(parse_constraint(constr,0)!=PARSE_OK){
+        *err= syntax_error.harderrstr ? syntax_error.harderrstr : syntax_error.softerrstr;
+        return MINITIP_SYNTAX;
+    }
+    if(!(*c=compile_constraint())){
+        *err="out of memory while storing this constraint";
+        return MINITIP_ERROR;
+    }
+    return MINITIP_TRUE;
+}
+
+int minitip_check_constraints(int constrno,
+        struct constraint_t *const constr[], const char *expr,
+        const struct lp_options_t *opt, const char **err, int *parsed)
+{int i,keep,parse; char *ret;
+    *err=""; if(parsed) *parsed=-1;
+    lp_stats_reset(); lp_stats_start(STAT_PARSE);
+    for(keep=0,i=0;i<constrno;i++,keep=1){
+        if(bind_constraint(constr[i],keep)!=PARSE_OK){
+            lp_stats_stop(STAT_PARSE);
+            *err=syntax_error.softerrstr; return MINITIP_SYNTAX;
+        }
+    }
+    parse=parse_entropy(expr,keep);
+    lp_stats_stop(STAT_PARSE);
+    if(parsed) *parsed=parse;
+    switch(parse){
+      case PARSE_ERR:
+        *err= syntax_error.harderrstr ? syntax_error.harderrstr : syntax_error.softerrstr;
+        return MINITIP_SYNTAX;
+      case PARSE_EQ: case PARSE_GE:
+        return MINITIP_TRUE;
+      default:
+        break;
+    }
+    ret=call_lp(constrno,constr,opt);
+    if(ret==EXPR_TRUE) return MINITIP_TRUE;
+    if(ret==EXPR_FALSE) return MINITIP_FALSE;
+    if(ret==EQ_GE_ONLY) return MINITIP_GE;
+    if(ret==EQ_LE_ONLY) return MINITIP_LE;
+    *err=ret; return MINITIP_ERROR;
+}
+
+int minitip_check(minitip_ctx *ctx, const char *expr, int constr)
+{int ret; const char *err; struct lp_options_t opt;
+    /* no forked solvers inside the host program */
+    opt=ctx->opt; opt.cert=NULL; opt.portfolio=1; opt.consensus=1;
+    if(!enter(ctx)) return MINITIP_ERROR;
+    ret=minitip_check_constraints(constr ? ctx->constraint_no : 0,
+              ctx->constraint,expr,&opt,&err,NULL);
+    if(ret==MINITIP_SYNTAX) syntax_err(ctx);
+    else set_error(ctx,err,-1);
+    leave(ctx);
+    return ret;
+}
+
+/* EOF */
+
@@ -0,0 +1,118 @@
+/* libminitip.h: minitip as a library */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* A context holds everything a minitip session has: the macro table
+* with the standard macros, the identifier table, the syntax style,
+* the constraints, the Shannon skeletons and the session LP, and the
+* LP options. Contexts are independent of each other and of the
+* command line program. The parser and the LP module keep their
+* state per thread: each call below swaps the state of the context
+* into the calling thread, and out when done. Thus contexts used by
+* different threads are checked at the same time. A context belongs
+* to the thread which created it, as its glpk problems belong to the
+* glpk environment of that thread (glpk must be built reentrant,
+* which is the default); calls from other threads return
+* MINITIP_ERROR. The result cache (cache.h) is shared by all contexts.
+*
+* minitip_ctx *minitip_new(void)
+*    a new context with the standard macros, simple style, no
+*    constraints, and the default options. NULL if out of memory.
+* void minitip_free(minitip_ctx *ctx)
+*    release the context; called by its owner thread.
+* void minitip_thread_end(void)
+*    release the work buffers and the glpk environment of the calling
+*    thread; call it after the thread has released its contexts.
+* struct lp_options_t *minitip_options(minitip_ctx *ctx)
+*    the LP options used by the checks of the context, see mklp.h;
+*    they can be changed directly. The cert field is not used, and
+*    portfolio and consensus are taken as 1: the library does not
+*    fork solver processes inside the host program.
+* const struct lp_stats_t *minitip_stats(minitip_ctx *ctx)
+*    phase times and LP size of the last check of the context.
+* void minitip_set_style(minitip_ctx *ctx, int full, char sepchar)
+*    use the full (original) or the simple style with the given
+*    separator character.
+*
+* The following calls return one of the MINITIP_* codes. When the
+* result is MINITIP_SYNTAX or MINITIP_ERROR, minitip_error() tells
+* what went wrong.
+*
+* int minitip_parse(minitip_ctx *ctx, const char *expr)
+*    check the syntax of the expression or relation; MINITIP_TRUE if
+*    it is correct.
+* int minitip_macro(minitip_ctx *ctx, const char *def)
+*    define a macro such as "Z(a,b|c)=(a,b)+(a|c)".
+* int minitip_add(minitip_ctx *ctx, const char *constr)
+*    add a constraint: a relation, functional dependency,
+*    independence or Markov chain.
+* int minitip_del(minitip_ctx *ctx, int idx)
+*    delete constraint idx (starting from zero); idx<0 deletes all.
+* int minitip_check(minitip_ctx *ctx, const char *expr, int constr)
+*    check the expression; the constraints are used when constr is
+*    set. MINITIP_TRUE, MINITIP_FALSE, or for == relations MINITIP_GE
+*    or MINITIP_LE when only one direction holds.
+* const char *minitip_error(minitip_ctx *ctx, int *pos)
+*    the error message of the last call; if pos is not NULL, it is set
+*    to the position of a syntax error, or -1.
+*
+* The command line program works on the state of the parser and the
+* LP module as it is, and uses the core of the calls above:
+* int minitip_compile_constraint(const char *constr,
+*        struct constraint_t **c, const char **err)
+*    parse and compile a constraint into *c. MINITIP_TRUE, or
+*    MINITIP_SYNTAX with the error in syntax_error, or MINITIP_ERROR.
+*    *err is set to the error message or to the empty string.
+* int minitip_check_constraints(int constrno,
+*        struct constraint_t *const constr[], const char *expr,
+*        const struct lp_options_t *opt, const char **err, int *parsed)
+*    the core of minitip_check(). lp_stats holds the time of the
+*    phases; *err is set as above. If parsed is not NULL, it gets the
+*    result of parse_entropy() (see parser.h), or -1 if a constraint
+*    could not be bound.
+*/
+
+#define MINITIP_TRUE	0	/* OK, the expression holds */
+#define MINITIP_FALSE	1	/* the expression does not hold */
+#define MINITIP_GE	2	/* only the >= part of == holds */
+#define MINITIP_LE	3	/* only the <= part of == holds */
+#define MINITIP_SYNTAX	4	/* syntax error */
+#define MINITIP_ERROR	5	/* other error, e.g. the LP failed */
+
+typedef struct minitip_ctx_t minitip_ctx;
+struct lp_options_t;
+struct lp_stats_t;
+struct constraint_t;
+
+minitip_ctx *minitip_new(void);
+void minitip_free(minitip_ctx *ctx);
+void minitip_thread_end(void);
+struct lp_options_t *minitip_options(minitip_ctx *ctx);
+const struct lp_stats_t *minitip_stats(minitip_ctx *ctx);
+void minitip_set_style(minitip_ctx *ctx, int full, char sepchar);
+
+int minitip_parse(minitip_ctx *ctx, const char *expr);
+int minitip_macro(minitip_ctx *ctx, const char *def);
+int minitip_add(minitip_ctx *ctx, const char *constr);
+int minitip_del(minitip_ctx *ctx, int idx);
+int minitip_check(minitip_ctx *ctx, const char *expr, int constr);
+const char *minitip_error(minitip_ctx *ctx, int *pos);
+
+int minitip_compile_constraint(const char *constr, struct constraint_t **c,
+        const char **err);
+int minitip_check_constraints(int constrno,
+        struct constraint_t *const constr[], const char *expr,
+        const struct lp_options_t *opt, const char **err, int *parsed);
+
+/* EOF */
+
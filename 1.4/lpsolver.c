@@ -0,0 +1,266 @@
+/* lpsolver.c: LP solver backends */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "minitip.h"
+#include "mklp.h"
+#include "lpsolver.h"
+
+/*----------------------------------------------------------------*/
+/* glp status and return codes */
+static minitip_THREAD char glp_msg_buffer[60];
+char *glp_status_msg(int stat)
+{static char *statmsg[] = {
+"solution is undefined",        // GLP_UNDEF
+"solution is feasible",         // GLP_FEAS
+"solution is unfeasible",       // GLP_INFEAS
+"no feasible solution exists",  // GLP_NOFEAS
+"solution is optimal",          // GLP_OPT
+"solution is unbounded",        // GLP_UNBND
+};
+    if(1<=stat && stat<=(int)((sizeof(statmsg)/sizeof(char*))) )
+       return statmsg[stat-1];
+    sprintf(glp_msg_buffer,"unknown solution state %d", stat);
+    return glp_msg_buffer;
+}
+char *glp_return_msg(int retval)
+{static char *retmsg[] = {
+"invalid basis",                        // GLP_EBADB     *
+"singular matrix",                      // GLP_ESING     *
+"ill-conditioned matrix",               // GLP_ECOND     *
+"invalid bounds",                       // GLP_EBOUND
+"solver failed",                        // GLP_EFAIL     *
+"objective lower limit reached",        // GLP_EOBJLL
+"objective upper limit reached",        // GLP_EOBJUL
+"iteration limit exceeded",             // GLP_EITLIM    *
+"time limit exceeded",                  // GLP_ETMLIM    *
+"no primal feasible solution",          // GLP_ENOPFS    *
+"no dual feasible solution",            // GLP_ENODFS
+"root LP optimum not provided",         // GLP_EROOT
+"search terminated by application",     // GLP_ESTOP
+"relative mip gap tolerance reached",   // GLP_EMIPGAP
+"no primal/dual feasible solution",     // GLP_ENOFEAS
+"no convergence",                       // GLP_ENOCVG
+"numerical instability",                // GLP_EINSTAB
+"invalid data",                         // GLP_EDATA
+"result out of range",                  // GLP_ERANGE
+};
+    if(1<=retval && retval <= (int)((sizeof(retmsg)/sizeof(char*))))
+        return retmsg[retval-1];
+    sprintf(glp_msg_buffer,"unknown lp code %d", retval);
+    return glp_msg_buffer;
+}
+
+/*----------------------------------------------------------------*/
+/* glpk: the LP is solved in place */
+static void glpk_reset(void)
+{   /* nothing is kept */ }
+
+static minitip_THREAD int glpk_it_cnt;	/* iterations in the last solve */
+static char *glpk_solve(glp_prob *P, const glp_smcp *parm)
+{int glp_res;
+    glpk_it_cnt=glp_get_it_cnt(P);
+    glp_res=glp_simplex(P,parm);
+    glpk_it_cnt=glp_get_it_cnt(P)-glpk_it_cnt;
+    switch(glp_res){
+  case 0:           glp_res=glp_get_status(P); break;
+  case GLP_ENOPFS:  // no primal feasible solution
+                    glp_res=GLP_NOFEAS; break;
+  default:          return glp_return_msg(glp_res);
+    }
+    return (glp_res==GLP_OPT ? EXPR_TRUE :
+            glp_res==GLP_NOFEAS ? EXPR_FALSE :
+            glp_status_msg(glp_res));
+}
+static double glpk_obj_val(glp_prob *P)
+{   return glp_get_obj_val(P); }
+static double glpk_col_prim(glp_prob *P, int j)
+{   return glp_get_col_prim(P,j); }
+static double glpk_row_dual(glp_prob *P, int i)
+{   return glp_get_row_dual(P,i); }
+static int glpk_iterations(glp_prob *P)
+{   (void)P; return glpk_it_cnt; }
+
+static const struct lp_solver_t glpk_solver = {
+    "glpk", glpk_reset, glpk_solve, glpk_obj_val, glpk_col_prim, glpk_row_dual,
+    glpk_iterations
+};
+
+/*----------------------------------------------------------------*/
+/* HiGHS: the LP is copied into a HiGHS object, which is kept until
+   reset() so that a new goal is solved from the last basis. */
+#ifdef HAVE_HIGHS
+#include "highs_c_api.h"
+
+static minitip_THREAD struct {
+    void *h;			/* the HiGHS object, NULL: no LP loaded */
+    int m,n;			/* number of rows and columns */
+    int maximize;		/* P is a maximization problem */
+    double *lower,*upper;	/* row bounds */
+    double *x,*dx,*r,*y;	/* column values and duals, row values
+				   and duals */
+} highs;
+
+static void highs_reset(void)
+{   if(highs.h) Highs_destroy(highs.h);
+    if(highs.lower) free(highs.lower);
+    if(highs.upper) free(highs.upper);
+    if(highs.x) free(highs.x);
+    if(highs.dx) free(highs.dx);
+    if(highs.r) free(highs.r);
+    if(highs.y) free(highs.y);
+    memset(&highs,0,sizeof(highs));
+}
+/* glpk bounds to HiGHS bounds */
+static void highs_bounds(int type, double lb, double ub, double inf,
+     double *lo, double *up)
+{   switch(type){
+  case GLP_FR:  *lo=-inf; *up=inf; break;
+  case GLP_LO:  *lo=lb; *up=inf; break;
+  case GLP_UP:  *lo=-inf; *up=ub; break;
+  case GLP_FX:  *lo=lb; *up=lb; break;
+  default:      *lo=lb; *up=ub; break;
+    }
+}
+/* copy the row bounds of P */
+static void highs_row_bounds(glp_prob *P)
+{int i; double inf;
+    inf=Highs_getInfinity(highs.h);
+    for(i=0;i<highs.m;i++)
+        highs_bounds(glp_get_row_type(P,i+1),glp_get_row_lb(P,i+1),
+             glp_get_row_ub(P,i+1),inf,&highs.lower[i],&highs.upper[i]);
+}
+/* load P into a new HiGHS object. Returns 1 if out of memory or
+   HiGHS rejects the LP */
+static int highs_load(glp_prob *P)
+{int i,j,k,len,ok,*ind; HighsInt *start,*index; double *val,*value,*cost,
+ *clo,*cup,inf,sign;
+    highs.m=glp_get_num_rows(P); highs.n=glp_get_num_cols(P);
+    highs.maximize= glp_get_obj_dir(P)==GLP_MAX;
+    highs.lower=malloc((highs.m+1)*sizeof(double));
+    highs.upper=malloc((highs.m+1)*sizeof(double));
+    highs.x=malloc((highs.n+1)*sizeof(double));
+    highs.dx=malloc((highs.n+1)*sizeof(double));
+    highs.r=malloc((highs.m+1)*sizeof(double));
+    highs.y=malloc((highs.m+1)*sizeof(double));
+    k=glp_get_num_nz(P);
+    start=malloc((highs.n+1)*sizeof(HighsInt));
+    index=malloc((k+1)*sizeof(HighsInt));
+    value=malloc((k+1)*sizeof(double));
+    cost=malloc((highs.n+1)*sizeof(double));
+    clo=malloc((highs.n+1)*sizeof(double));
+    cup=malloc((highs.n+1)*sizeof(double));
+    ind=malloc((highs.m+1)*sizeof(int));
+    val=malloc((highs.m+1)*sizeof(double));
+    ok = highs.lower && highs.upper && highs.x && highs.dx && highs.r &&
+         highs.y && start && index && value && cost && clo && cup && ind && val;
+    if(ok) ok = (highs.h=Highs_create())!=NULL;
+    if(ok){
+        Highs_setBoolOptionValue(highs.h,"output_flag",0);
+        Highs_setIntOptionValue(highs.h,"threads",1); // we fork
+        inf=Highs_getInfinity(highs.h);
+        sign = highs.maximize ? -1.0 : 1.0; // HiGHS minimizes
+        for(j=0,k=0;j<highs.n;j++){
+            start[j]=k;
+            len=glp_get_mat_col(P,j+1,ind,val);
+            for(i=1;i<=len;i++,k++){ index[k]=ind[i]-1; value[k]=val[i]; }
+            cost[j]=sign*glp_get_obj_coef(P,j+1);
+            highs_bounds(glp_get_col_type(P,j+1),glp_get_col_lb(P,j+1),
+                 glp_get_col_ub(P,j+1),inf,&clo[j],&cup[j]);
+        }
+        start[highs.n]=k;
+        highs_row_bounds(P);
+        ok = Highs_passLp(highs.h,highs.n,highs.m,k,kHighsMatrixFormatColwise,
+             kHighsObjSenseMinimize,sign*glp_get_obj_coef(P,0),cost,clo,cup,
+             highs.lower,highs.upper,start,index,value)!=kHighsStatusError;
+    }
+    if(start) free(start);
+    if(index) free(index);
+    if(value) free(value);
+    if(cost) free(cost);
+    if(clo) free(clo);
+    if(cup) free(cup);
+    if(ind) free(ind);
+    if(val) free(val);
+    if(!ok) highs_reset();
+    return !ok;
+}
+
+static char *highs_solve(glp_prob *P, const glp_smcp *parm)
+{int i;
+    if(!highs.h){
+        if(highs_load(P)) return "HiGHS cannot load the LP";
+    } else { // new goal
+        highs_row_bounds(P);
+        Highs_changeRowsBoundsByRange(highs.h,0,highs.m-1,highs.lower,highs.upper);
+    }
+    Highs_setStringOptionValue(highs.h,"solver","simplex");
+    Highs_setIntOptionValue(highs.h,"simplex_strategy",
+         parm->meth==GLP_PRIMAL ? 4 : 1); // primal or dual
+    Highs_setStringOptionValue(highs.h,"presolve",
+         parm->presolve==GLP_ON ? "on" : "off");
+    Highs_setIntOptionValue(highs.h,"simplex_iteration_limit",parm->it_lim);
+    Highs_setDoubleOptionValue(highs.h,"time_limit",parm->tm_lim/1000.0);
+    if(Highs_run(highs.h)==kHighsStatusError) return "HiGHS solver failed";
+    switch(Highs_getModelStatus(highs.h)){
+  case kHighsModelStatusOptimal:
+        Highs_getSolution(highs.h,highs.x,highs.dx,highs.r,highs.y);
+        if(highs.maximize) for(i=0;i<highs.m;i++) highs.y[i] = -highs.y[i];
+        return EXPR_TRUE;
+  case kHighsModelStatusInfeasible:
+        return EXPR_FALSE;
+  case kHighsModelStatusIterationLimit:
+        return "iteration limit exceeded";
+  case kHighsModelStatusTimeLimit:
+        return "time limit exceeded";
+  case kHighsModelStatusUnbounded:
+        return "solution is unbounded";
+    }
+    return "HiGHS solver failed";
+}
+static double highs_obj_val(glp_prob *P)
+{double v; (void)P;
+    v=Highs_getObjectiveValue(highs.h);
+    return highs.maximize ? -v : v;
+}
+static double highs_col_prim(glp_prob *P, int j)
+{   (void)P; return highs.x[j-1]; }
+static double highs_row_dual(glp_prob *P, int i)
+{   (void)P; return highs.y[i-1]; }
+static int highs_iterations(glp_prob *P)
+{HighsInt cnt; (void)P;
+    if(!highs.h || Highs_getIntInfoValue(highs.h,"simplex_iteration_count",
+         &cnt)!=kHighsStatusOk) return 0;
+    return (int)cnt;
+}
+
+static const struct lp_solver_t highs_solver = {
+    "HiGHS", highs_reset, highs_solve, highs_obj_val, highs_col_prim, highs_row_dual,
+    highs_iterations
+};
+#endif /* HAVE_HIGHS */
+
+/*----------------------------------------------------------------*/
+const struct lp_solver_t *lp_get_solver(int which)
+{   switch(which){
+  case 0:  return &glpk_solver;
+#ifdef HAVE_HIGHS
+  case 1:  return &highs_solver;
+#endif
+    }
+    return NULL;
+}
+
+/* EOF */
@@ -0,0 +1,57 @@
+/* lpsolver.h: LP solver backends */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* The LP is assembled in a glpk problem object; this is the model all
+* backends work from. A backend solves it and reports the solution.
+*
+* struct lp_solver_t
+*    name        the name of the solver
+*    reset()     forget the internal copy of the LP: the matrix of P
+*                has changed, or P has been deleted
+*    solve(P,parm)
+*                solve P. The limits, the simplex method and presolve
+*                are taken from parm. If the backend keeps a copy of P,
+*                only the row bounds (the goal) are updated from P.
+*                Returns EXPR_TRUE if an optimal solution was found,
+*                EXPR_FALSE if P is infeasible, or an error message.
+*    obj_val(P), col_prim(P,j), row_dual(P,i)
+*                values of the last optimal solution; row duals follow
+*                the glpk convention d_j = c_j - sum_i a_ij y_i.
+*    iterations(P)
+*                number of simplex iterations in the last solve(P).
+*
+* const struct lp_solver_t *lp_get_solver(int which)
+*    0: glpk, 1: HiGHS. Returns NULL if the solver is not compiled in.
+* char *glp_status_msg(int stat), char *glp_return_msg(int retval)
+*    glpk status and return codes as text.
+*/
+
+#include "glpk.h"
+
+struct lp_solver_t {
+    const char *name;
+    void (*reset)(void);
+    char *(*solve)(glp_prob *P, const glp_smcp *parm);
+    double (*obj_val)(glp_prob *P);
+    double (*col_prim)(glp_prob *P, int j);
+    double (*row_dual)(glp_prob *P, int i);
+    int (*iterations)(glp_prob *P);
+};
+
+const struct lp_solver_t *lp_get_solver(int which);
+
+char *glp_status_msg(int stat);
+char *glp_return_msg(int retval);
+
+/* EOF */
@@ -14,7 +14,7 @@
 /* Version and copyright */
 #define VERSION_MAJOR	1
 #define VERSION_MINOR	4
-#define VERSION_SUB	8
+#define VERSION_SUB	9
 #define VERSION_STRING	mkstringof(VERSION_MAJOR.VERSION_MINOR.VERSION_SUB)
 
 #define COPYRIGHT	\
@@ -28,10 +28,14 @@
 
 #include "minitip.h"
 #include "parser.h"
+#include "mklp.h"
+#include "cache.h"
+#include "libminitip.h"
 #include "xassert.h"
 
 /* forward declarations */
-static void check_expression(const char *src, int with_constraints);
+static void print_check_result(int ret, const char *err, const char *constr);
+static struct lp_options_t *lp_options(void);
 extern int yesno(int,const char *fmt, ...);
 static int get_param(const char *str);
 static void set_param(const char *str,int value);
@@ -42,6 +46,8 @@ static void set_param(const char *str,int value);
 *
 *  char *HISTORY_FILE
 *     read from and save history to this file.
+*  char *CACHE_FILE
+*     the result cache is read from and saved to this file.
 *  int done
 *     has value zero until the "quit" command is encountered, which set
 *     this variable to 1
@@ -57,6 +63,7 @@ static void set_param(const char *str,int value);
 *     this variable is used to offset the starting position.
 */
 static char *HISTORY_FILE=NULL;
+static char *CACHE_FILE=NULL;
 static int done=0;
 static int in_minitiprc=0;
 static syntax_style_t minitip_style=minitip_INITIAL_STYLE;
@@ -78,19 +85,30 @@ static char batch_line[minitip_MAX_LINE_LENGTH+5];
 *  int constraint_no
 *     the number of active constraints
 *  char *constraint_table[max_constraints]
-*     the original form of the constraint. It is parsed freshly when
-*     the constraint is required, as it contains variable names.
+*     the original form of the constraint as it was entered.
+*  struct constraint_t *constraint_code[max_constraints]
+*     the compiled form of the constraint. It is created when the
+*     constraint is added, and bound to the actual variables when an
+*     expression is checked.
 *  int resize_constraint_table(newsize)
 *     resize the constraint table to the given one. Returns the new
 *     size which is the max of occupied slots and newsize
+*  void free_constraint_slot(int idx)
+*     release the memory of the constraint in slot idx
 */
 static int max_constraints=0;
 static int constraint_no=0;
 char **constraint_table=NULL;
+static struct constraint_t **constraint_code=NULL;
 
 static int resize_constraint_table(int newsize)
-{char **newtable;
+{char **newtable; struct constraint_t **newcode;
     if(newsize< constraint_no) newsize=constraint_no;
+    newcode=realloc(constraint_code,newsize*sizeof(struct constraint_t*));
+    if(newcode==NULL){ // no change
+       return max_constraints;
+    }
+    constraint_code=newcode;
     newtable=realloc(constraint_table,newsize*sizeof(char*));
     if(newtable==NULL){ // no change
        return max_constraints; 
@@ -98,6 +116,11 @@ static int resize_constraint_table(int newsize)
     max_constraints=newsize; constraint_table=newtable;
     return max_constraints;
 }
+static void free_constraint_slot(int idx)
+{   free(constraint_table[idx]);
+    free_constraint(constraint_code[idx]);
+    invalidate_lp();
+}
 
 /***********************************************************************
 *  int cmp_s(char *s2, char *s1)
@@ -603,13 +626,24 @@ static int com_args(UNUSED const char *arg, const char *line)
 "   -c <file>  -- use <file> as the config file (default: " DEFAULT_RC_FILE ")\n"
 "   -c-        -- don't read the default config file\n"
 "   -m <macro> -- add this macro definition\n"
+"   -T         -- print timing and LP size statistics of each check\n"
+"   -R <seed>  -- seed of the random generator, for reproducible runs\n"
 "\n"
 "the following flags imply non-iteractive usage:\n"
 "   -q         -- quiet, just check, don't print anything\n"
+"   -C <file>  -- write the certificate of the result to <file>\n"
+"   -b <file>  -- check each line of <file> ('-' is stdin), write one result line\n"
+"   -J         -- write the results of '-b' as JSON objects instead of TSV\n"
+"   -j <N>     -- check the lines of '-b' in N parallel processes (0: one per CPU)\n"
+"   --serve <socket> -- answer check requests on a Unix socket, N workers with '-j'\n"
+"   --client <socket> -- send the expression, or stdin lines, to the server\n"
+"   --pipe     -- read commands from stdin, write one result line for each\n"
 "   -v         -- version and copyright information\n"
 "   -e         -- last flag, followed by the expression to be checked\n"
 "   <expr> <constr1> <constr2> ...\n"
 "              -- <expr> is checked using the given constraints\n"
+"   -b <file> <constr1> <constr2> ...\n"
+"              -- each line of <file> is checked using the given constraints\n"
 "\n");
     return 0; /* OK */
 }
@@ -925,7 +959,7 @@ static int com_syntax(const char *argv, const char *line)
 }
 /** ADD  -- add a constraint **/
 static int com_add(const char* line,const char *orig)
-{int i;
+{int i,ret; struct constraint_t *code; const char *err;
     if(*line==0 || *line=='?' || strncmp(line,"help",4)==0){ // empty line, help
         if(!orig) printf(
 " Add a new constraint, which can be an equality or inequality\n"
@@ -940,18 +974,27 @@ static int com_add(const char* line,const char *orig)
         printf(" This constraint is #%d, no need to add again\n",i+1);
         return 1; /* abort */
     }
-    if(parse_constraint(line,0)!=PARSE_OK){ // some error
+    ret=minitip_compile_constraint(line,&code,&err);
+    if(ret==MINITIP_SYNTAX){ // some error
         error_message(orig);
         return 2; /* abort */
     }
-    if(constraint_no>=max_constraints-1){
+    if(ret==MINITIP_TRUE && constraint_no>=max_constraints-1){
+        free_constraint(code);
         if(orig)printf("%s\n",orig);
         printf("ERROR: too many constraints (max %d)\n"
                "  use 'del <number>' to delete some constraints\n",max_constraints);
         return 2; /* fatal; abort */
     }
+    if(ret!=MINITIP_TRUE){
+        if(orig)printf("%s\n",orig);
+        printf("ERROR: %s\n",err);
+        return 2; /* fatal; abort */
+    }
+    constraint_code[constraint_no]=code;
     constraint_table[constraint_no]=strdup(line);
     constraint_no++;
+    invalidate_lp();
     return 0; /* OK */
 }
 
@@ -1065,7 +1108,7 @@ static int com_del(const char *arg, const char *line)
            c=yesno(0," All constraints (%d) will be deleted. Proceed (y/n)? ",constraint_no);
         }
         if(c!=0){
-           for(no=0;no<constraint_no;no++) free(constraint_table[no]);
+           for(no=0;no<constraint_no;no++) free_constraint_slot(no);
            constraint_no=0;
         }
         return 0; /* OK */
@@ -1078,9 +1121,10 @@ static int com_del(const char *arg, const char *line)
     }
     if(!line)
       printf(" This constraint has been deleted:\n   %s\n",constraint_table[no-1]);
-    free(constraint_table[no-1]);
+    free_constraint_slot(no-1);
     while(no<constraint_no){
-       constraint_table[no-1]=constraint_table[no]; no++;
+       constraint_table[no-1]=constraint_table[no];
+       constraint_code[no-1]=constraint_code[no]; no++;
     }
     constraint_no--;
     return 0; /* OK */
@@ -1102,7 +1146,7 @@ static int com_style(const char *argv, const char *line)
             if(yesno(0," Changing style will delete all constraints (%d). Proceed (y/n)? ",
                 constraint_no)==0) return 1;
             while(constraint_no>0){
-                constraint_no--; free(constraint_table[constraint_no]);
+                constraint_no--; free_constraint_slot(constraint_no);
             }
         }
         minitip_style=syntax_full; minitip_sepchar=';';
@@ -1132,7 +1176,7 @@ static int com_style(const char *argv, const char *line)
             if(yesno(0," Changing style will delete all constraints (%d). Proceed (y/n)? ",
                 constraint_no)==0) return 1;
             while(constraint_no>0){
-                constraint_no--; free(constraint_table[constraint_no]);
+                constraint_no--; free_constraint_slot(constraint_no);
             }
         }
         minitip_style=syntax_short; minitip_sepchar=sepchar;
@@ -1176,40 +1220,10 @@ static int com_style(const char *argv, const char *line)
 */
 static int standard_macros=0,standard_measures=0;
 
-static inline void addchar(char *str,char c){
-    while(*str){str++;} str[0]=c; str[1]='\0';
-}
-static inline void addstr(char *str,const char *t){
-    while(*str){str++;} while(*t){*str=*t; str++;t++;}
-    *str='\0';
-}
-static inline void addseq(char *str,int d)
-{int i;
-    for(i=3;i<d;i++){addchar(str,',');addchar(str,-1+'a'+i);}
-}
 static void setup_standard_macros(void)
-{char buff[minitip_MAX_EXPR_LENGTH]; int d;
-    set_syntax_style(syntax_short,',',1);
-    if(parse_macro_definition("H(a)=a")!=PARSE_OK) error_message(NULL);
-    if(parse_macro_definition("H(a|b)=ab-b")!=PARSE_OK) error_message(NULL);
-    if(parse_macro_definition("I(a,b)=a+b-ab")!=PARSE_OK) error_message(NULL);
-    if(parse_macro_definition("I(a,b|c)=ac+bc-c-abc")!=PARSE_OK) error_message(NULL);
-    // additional measures
-    // I(a,b,x)  =I(a,b)-I(a,b|x)
-    // I(a,b,x|y)=I(a,b|y)- I(a,b|xy), etc.
-    standard_measures = macro_total;
-    for(d=3;d<minitip_MAX_MEASURE_DEPTH;d++){
-       buff[0]=0; addstr(buff,"I(a,b"); addseq(buff,d);
-       addstr(buff,",x)=I(a,b"); addseq(buff,d);
-       addstr(buff,")-I(a,b"); addseq(buff,d);addstr(buff,"|x)");
-       if(parse_macro_definition(buff)!=PARSE_OK) error_message(NULL);
-       buff[0]=0; addstr(buff,"I(a,b"); addseq(buff,d);
-       addstr(buff,",x|y)=I(a,b"); addseq(buff,d);
-       addstr(buff,"|y)-I(a,b"); addseq(buff,d);addstr(buff,"|xy)");
-       if(parse_macro_definition(buff)!=PARSE_OK) error_message(NULL);
-    }
+{   standard_measures=parse_standard_macros();
+    if(standard_measures<0) error_message(NULL);
     standard_macros = macro_total;
-//  if(parse_macro_definition("D(a,b,c)=(a,b|c)+(b,c|a)+(c,a|b)")) error_message(NULL);
 }
 
 /** MACRO add -- define a new macro **/
@@ -1366,8 +1380,19 @@ typedef struct {
 
 static PARAMETERS parameters[] = {
 /* name		type	 value	lower	upper		doc                */
-{"iterlimit",	NULL,	80000,	100,	100000000,	"LP iteration limit"},
-{"timelimit",	NULL,	10,	1,	10000,		"LP time limit in seconds"},
+{"solver",	"glpk/highs/builtin",1,1,3,		"glpk/highs/builtin - the LP solver"},
+{"iterlimit",	NULL,	minitip_ITERLIMIT,100,	100000000,	"LP iteration limit"},
+{"timelimit",	NULL,	minitip_TIMELIMIT,1,	minitip_MAX_TIMELIMIT,"LP time limit in seconds"},
+{"portfolio",	NULL,	1,	1,	16,		"number of LP solvers racing in parallel"},
+{"consensus",	NULL,	1,	1,	16,		"number of LP solvers voting on the result"},
+{"verify",	"yes/no",	2,1,2,			"yes/no - verify the result in exact arithmetic"},
+{"symmetry",	"yes/no",	2,1,2,			"yes/no - reduce the LP by variable symmetries"},
+{"lazy",	"no/yes/auto",	3,1,3,			"no/yes/auto - add Shannon inequalities on demand"},
+{"formulation",	"primal/dual/auto",1,1,3,		"primal/dual/auto - which LP to solve"},
+{"stats",	"yes/no",	2,1,2,			"yes/no - print timing and LP size of each check"},
+{"cachesize",	NULL,	10000,	10,	10000000,	"number of results kept in the cache"},
+{"cachefile",	"",		1,1,1,			"file storing the result cache"},
+{"cache",	"yes/no",	2,1,2,			"yes/no - keep results in the cache file"},
 {"constrlimit", NULL,	50,	10,	100000,		"maximal number of constraints"},
 {"macrolimit",	NULL,	50,	10,	100000,		"maximal number of macros"},
 {"run",		"strict/loose",	1,1,2,			"strict/loose - how to handle errors in run file"},
@@ -1391,6 +1416,10 @@ static char *show_choice(const char *str, int c)
    *b=0;
    return buf;
 }
+/* file name parameters */
+static char **file_param(const PARAMETERS *p)
+{   return strcmp(p->name,"cachefile")==0 ? &CACHE_FILE : &HISTORY_FILE; }
+static void close_cache(void);
 static void show_parameter(char *buf,int idx)
 {PARAMETERS *p=&parameters[idx];
 char *str=p->type;
@@ -1398,8 +1427,8 @@ char *str=p->type;
       sprintf(buf,"%s=%d",p->name,p->value);
       return;
     }
-    if(*str==0){ // default history file
-      sprintf(buf,"%s=%s",p->name,HISTORY_FILE);
+    if(*str==0){ // history or cache file
+      sprintf(buf,"%s=%s",p->name,*file_param(p));
       return;
     }
     // choice
@@ -1496,13 +1525,14 @@ static int com_set(const char *arg, const char *line)
                 }                P->value=n;
                 return 0;
            }
-           if(*(P->type)==0){ // history file
+           if(*(P->type)==0){ // history or cache file
                 char *newfile=prepare_filename(arg);
                 if(newfile==NULL){
                     printf(" Wrong filename syntax\n");
                     return 1;
                 }
-                free(HISTORY_FILE); HISTORY_FILE=newfile;
+                if(file_param(P)==&CACHE_FILE) close_cache();
+                free(*file_param(P)); *file_param(P)=newfile;
                 return 0;
            }
            while(*arg==' '||*arg=='\t') arg++;
@@ -1681,22 +1711,51 @@ static int com_batch(const char *arg,const char *line)
 
 /** CHECK -- check entropy relation with all constraints **/
 
-static int com_check(const char *line, const char *orig)
-{int i,keep,parse;;
-    if(in_minitiprc) return 0;
-    if(!*line || *line=='?' || strcmp(line,"help")==0){
-        if(!orig)printf(" Check the validity of an entropy relation with all constraints.\n"
-                        " Enter 'syntax relation' for more help.\n");
-        return 0; /* empty line, OK */
-    }
-    keep=0; // add all constraints
-    for(i=0;i<constraint_no;i++){
-        parse_constraint(constraint_table[i],keep); keep=1;
-    }
-    parse=parse_entropy(line,keep);
-    if(parse==PARSE_ERR){
-          error_message(orig);
-          return 1;
+/* certificate file for 'check -cert <file>' and flag -C; used by
+   lp_options() */
+static FILE *cert_file=NULL;
+/* if line starts with -cert <file>, open the file and return the rest
+   of the line; return NULL on error. "-cert >= ..." in simple style
+   is a relation, not a file name. */
+static const char *open_cert_file(const char *line, const char *orig)
+{int i; char buf[MAX_PATH_LENGTH+1]; const char *rest; char *fname;
+    if(strncmp(line,"-cert",5)!=0 || (line[5]!=' ' && line[5]!='\t'))
+        return line;
+    for(rest=line+5; *rest==' '||*rest=='\t'; rest++);
+    if(*rest=='=' || *rest=='<' || *rest=='>') return line;
+    for(i=0;i<MAX_PATH_LENGTH && rest[i] && rest[i]!=' ' && rest[i]!='\t';i++)
+        buf[i]=rest[i];
+    buf[i]=0; rest+=i;
+    while(*rest==' '||*rest=='\t') rest++;
+    if(*rest==0) return line;
+    cmdarg_position += rest-line;
+    if(!(fname=prepare_filename(buf))){
+        if(orig) printf("%s\n",orig);
+        printf("ERROR: wrong certificate file name\n");
+        return NULL;
+    }
+    cert_file=fopen(fname,"w");
+    if(!cert_file){
+        if(orig) printf("%s\n",orig);
+        printf("ERROR: cannot open certificate file %s\n",fname);
+    }
+    free(fname);
+    return cert_file ? rest : NULL;
+}
+
+/* check relation with all constraints */
+static int com_check_relation(const char *line, const char *orig)
+{int ret,parse; const char *err;
+    ret=minitip_check_constraints(constraint_no,constraint_code,line,
+            lp_options(),&err,&parse);
+    if(ret==MINITIP_SYNTAX){
+        if(parse==PARSE_ERR){
+            error_message(orig);
+        } else { // a constraint cannot be bound
+            if(orig) printf("%s\n",orig);
+            printf("ERROR: %s\n",err);
+        }
+        return 1;
     }
     if(orig) printf("%s\n",orig);
     switch(parse){
@@ -1705,22 +1764,37 @@ static int com_check(const char *line, const char *orig)
       case PARSE_GE:
           printf(res_TRUEGE "\n"); break;
       default:
-          check_expression(line,1); break;
+          print_check_result(ret,err,constraint_no>0 ? res_CONSTR : ""); break;
     }
     return 0; /* OK */
 }
+static int com_check(const char *line, const char *orig)
+{int ret;
+    if(in_minitiprc) return 0;
+    if(!*line || *line=='?' || strcmp(line,"help")==0){
+        if(!orig)printf(" Check the validity of an entropy relation with all constraints.\n"
+                        " Use 'check -cert <file> <relation>' to write a certificate.\n"
+                        " Enter 'syntax relation' for more help.\n");
+        return 0; /* empty line, OK */
+    }
+    if(!(line=open_cert_file(line,orig))) return 1;
+    ret=com_check_relation(line,orig);
+    if(cert_file){ fclose(cert_file); cert_file=NULL; }
+    return ret;
+}
 
 /** NOCON -- check entropy relation without constraints **/
 static int com_nocon(const char *line, const char *orig)
-{int parse;
+{int ret,parse; const char *err;
     if(in_minitiprc) return 0;
     if(!*line || *line=='?' || strcmp(line,"help")==0){
         if(!orig)printf(" Crosscheck an entropy relation without any constraints.\n"
                         " Enter 'syntax relation' for more help.\n");
         return 0;
     }
-    parse=parse_entropy(line,0);
-    if(parse==PARSE_ERR){
+    ret=minitip_check_constraints(0,constraint_code,line,lp_options(),
+            &err,&parse);
+    if(ret==MINITIP_SYNTAX){
         error_message(orig);
         return 1;
     }
@@ -1734,7 +1808,7 @@ static int com_nocon(const char *line, const char *orig)
          if(constraint_no>0){
            printf("Checking without constraints ...\n");
          }
-         check_expression(line,0); break;
+         print_check_result(ret,err,""); break;
     }
     return 0;
 }
@@ -1795,75 +1869,185 @@ static int com_nat(const char *line, const char *orig)
 /***********************************************************************
 * Interface to the LP solver
 *
-*    The argument of call_lp(func) is called as ret=func(idx); it 
-*    should parse the expression to be evaluated when idx<0, otherwise
-*    the constraint with index idx. The ret value is 0 if a constraint
-*    with index idx exists, otherwise 1. (There could be no error at
-*    this stage.)
-*  char *expr_to_check
-*  int use_constraints
-*    used to pass info to compute_expression(idx) which realizes the 
-*    function argument to call_lp().
-*  int compute_expression(int idx)
-*    the argument to call_lp()
-*  void check_expression(char *src, int with_constraints)
-*    calls the lp solver and prints out the result.
+*    Expressions are checked by minitip_check_constraints(), see
+*    libminitip.h, with the compiled constraints as an array.
+*  struct lp_options_t *lp_options(void)
+*    LP solver parameters from the runtime parameters. When the cache
+*    is used, it is read from CACHE_FILE first.
+*  void close_cache(void)
+*    save the result cache to CACHE_FILE if it has changed, and drop it.
+*  void print_consensus(void)
+*    in consensus mode print how the solvers voted.
+*  void print_verified(void)
+*    print how the result was verified.
+*  void print_formulation(void)
+*    print which LP was solved unless the primal one was asked for, or
+*    that the result was found in the cache.
+*  void print_stats(void)
+*    print the time of the phases and the LP size when stats is set.
+*  void print_check_result(int ret, char *err, char *constr)
+*    print the result ret of minitip_check_constraints() which is not
+*    a syntax error; constr is appended to the verdict.
 *  int check_offline_expression(char *src, int quiet)
-*    calls the lp solver; prints out the result if quiet is not set, 
-*    and determines the exit value of minitip.
+*    checks src with the constraints; prints out the result if quiet
+*    is not set, and determines the exit value of minitip. Writes the
+*    certificate when the flag -C was given.
 */
 
-#include "mklp.h"
-static const char *expr_to_check;
-static int use_constraints;
-/* parses expr_to_check if i<0; otherwise parses the i'th constraint.
-   return 1 if no such constrain exists */
-static int compute_expression(int i)
-{
-    if(i<0){ parse_entropy(expr_to_check,1); return 0; }
-    if(!use_constraints || i>=constraint_no) return 1;
-    parse_constraint(constraint_table[i],1);
-    return 0;
-}
-
-static void check_expression(const char *src, int with_constraints)
-{char *ret; char *constr,*outstr;
-    expr_to_check=src; use_constraints=with_constraints;
-    ret=call_lp(compute_expression,get_param("iterlimit"),get_param("timelimit"));
-    constr= with_constraints && constraint_no>0 ? res_CONSTR : "";
-    if(ret==EXPR_TRUE){
-        outstr=res_TRUE;
-    } else if(ret==EXPR_FALSE){
-        outstr=res_FALSE;
-    } else if(ret==EQ_GE_ONLY){
-        outstr=res_ONLYGE;
-    } else if(ret==EQ_LE_ONLY){
-        outstr=res_ONLYLE;
-    } else {
-        printf("ERROR in solving the LP: %s\n",ret);
+static int cache_loaded=0; /* CACHE_FILE has been read */
+static void close_cache(void)
+{   if(cache_stats.changed && cache_save(CACHE_FILE)!=0)
+        printf("ERROR: cannot save the result cache to %s\n",CACHE_FILE);
+    cache_clear(); cache_loaded=0;
+}
+
+static struct lp_options_t *lp_options(void)
+{static struct lp_options_t opt;
+    opt.solver=get_param("solver")-1;
+    opt.iterlimit=get_param("iterlimit");
+    opt.timelimit=get_param("timelimit");
+    opt.portfolio=get_param("portfolio");
+    opt.consensus=get_param("consensus");
+    opt.verify= get_param("verify")==1;
+    opt.symmetry=get_param("symmetry")==1;
+    switch(get_param("lazy")){ // from how many variables
+      case 1:  opt.lazy=0; break;
+      case 2:  opt.lazy=2; break;
+      default: opt.lazy=LAZY_AUTO_VARNO; break;
+    }
+    opt.formulation=get_param("formulation")-1;
+    opt.cache=get_param("cache")==1;
+    if(opt.cache){
+        cache_limit(get_param("cachesize"));
+        if(!cache_loaded){ cache_load(CACHE_FILE); cache_loaded=1; }
+    }
+    opt.cert=cert_file;
+    return &opt;
+}
+
+static void print_consensus(void)
+{   if(lp_consensus.solvers<=1) return;
+    printf("    %d of %d solvers agree",lp_consensus.agree,lp_consensus.solvers);
+    if(lp_consensus.differ) printf(", %d disagree",lp_consensus.differ);
+    if(lp_consensus.failed) printf(", %d failed",lp_consensus.failed);
+    printf("\n");
+}
+static void print_verified(void)
+{   switch(lp_verified){
+  case VERIFY_CERT:   printf("    verified in exact arithmetic\n"); break;
+  case VERIFY_EXACT:  printf("    verified by the exact simplex method\n"); break;
+  case VERIFY_FIXED:  printf("    WARNING: corrected by the exact simplex method\n"); break;
+  case VERIFY_FAILED: printf("    WARNING: the result could not be verified\n"); break;
+  default: break;
+    }
+}
+
+static void print_formulation(void)
+{   if(lp_stats.cached){ printf("    taken from the result cache\n"); return; }
+    if(get_param("formulation")==1) return;
+    printf("    solved by the %s LP\n",lp_formulation==LP_DUAL ? "dual" : "primal");
+}
+
+static void print_stats(void)
+{static const char *phase[STAT_PHASES]={"parse","variables","build","solve","verify"};
+ int i;
+    if(get_param("stats")!=1) return;
+    printf("    var_no %d, rows %d, columns %d, nonzeros %ld, iterations %ld,"
+           " glpk peak memory %lu kB\n",lp_stats.var_no,lp_stats.rows,
+           lp_stats.cols,lp_stats.nonzeros,lp_stats.iterations,
+           (unsigned long)(lp_stats.mem_peak+1023)/1024);
+    printf("    time (ms)");
+    for(i=0;i<STAT_PHASES;i++) printf(" %9s",phase[i]);
+    printf("\n    wall     ");
+    for(i=0;i<STAT_PHASES;i++) printf(" %9.3f",1000.0*lp_stats.wall[i]);
+    printf("\n    cpu      ");
+    for(i=0;i<STAT_PHASES;i++) printf(" %9.3f",1000.0*lp_stats.cpu[i]);
+    printf("\n");
+    if(get_param("cache")==1)
+        printf("    result cache: %s, %d entries, %ld hits, %ld misses\n",
+           lp_stats.cached ? "hit" : "miss",cache_stats.entries,
+           cache_stats.hits,cache_stats.misses);
+}
+
+static void print_check_result(int ret, const char *err, const char *constr)
+{const char *outstr;
+    switch(ret){
+      case MINITIP_TRUE:  outstr=res_TRUE; break;
+      case MINITIP_FALSE: outstr=res_FALSE; break;
+      case MINITIP_GE:    outstr=res_ONLYGE; break;
+      case MINITIP_LE:    outstr=res_ONLYLE; break;
+      default:
+        printf("ERROR in solving the LP: %s\n",err);
+        print_consensus(); print_stats();
         return;
     }
     printf("%s%s\n",outstr,constr);
+    print_consensus(); print_verified(); print_formulation(); print_stats();
 }
+static char *cert_name=NULL; /* certificate file after flag -C */
 static int check_offline_expression(const char *src, int quiet)
-{char *ret; char *constr,*outstr;
-    expr_to_check=src; use_constraints=1;
-    ret=call_lp(compute_expression,get_param("iterlimit"),get_param("timelimit"));
-    if(!quiet){
-      constr= constraint_no>0 ? res_CONSTR : "";
-      if(ret==EXPR_TRUE){       outstr=res_TRUE; }
-      else if(ret==EXPR_FALSE){ outstr=res_FALSE; constr=""; }
-      else if(ret==EQ_GE_ONLY){ outstr=res_ONLYGE; }
-      else if(ret==EQ_LE_ONLY){ outstr=res_ONLYLE; }
-      else {
-        printf("ERROR in solving the LP: %s\n",ret);
+{int ret,parse; const char *err;
+    if(cert_name && !(cert_file=fopen(cert_name,"w"))){
+        if(!quiet) printf("ERROR: cannot open certificate file %s\n",cert_name);
         return EXIT_ERROR;
-      }
-      printf("%s\n%s%s\n",src,outstr,constr);
     }
-    return ret==EXPR_TRUE ? EXIT_TRUE :
-       ret==EXPR_FALSE || ret==EQ_GE_ONLY || ret== EQ_LE_ONLY ? EXIT_FALSE :
-       EXIT_ERROR ;
+    ret=minitip_check_constraints(constraint_no,constraint_code,src,
+            lp_options(),&err,&parse);
+    if(cert_file){ fclose(cert_file); cert_file=NULL; }
+    if(ret==MINITIP_SYNTAX){
+        if(!quiet){
+            if(parse==PARSE_ERR) error_message(src);
+            else printf("ERROR: %s\n",err);
+        }
+        return EXIT_SYNTAX;
+    }
+    if(parse==PARSE_EQ || parse==PARSE_GE){
+        if(!quiet) printf(parse==PARSE_EQ ? res_TRUEEQ "\n" : res_TRUEGE "\n");
+        return EXIT_TRUE;
+    }
+    if(!quiet){
+        if(ret!=MINITIP_ERROR) printf("%s\n",src);
+        print_check_result(ret,err,
+            ret==MINITIP_FALSE || constraint_no==0 ? "" : res_CONSTR);
+    }
+    return ret==MINITIP_TRUE ? EXIT_TRUE : ret==MINITIP_ERROR ? EXIT_ERROR :
+       EXIT_FALSE;
+}
+
+/***********************************************************************
+*  int add_offline_constraints(int argc, char *argv[], int quiet)
+*
+*    add argv[0..argc-1] as constraints. Returns EXIT_TRUE if OK, or
+*    the exit value when some of them could not be added.
+*/
+static int add_offline_constraints(int argc, char *argv[], int quiet)
+{int i,j,ret; struct constraint_t *code; const char *err;
+    for(i=0;i<argc;i++){
+        for(j=0;j<constraint_no;j++) if(strcmp(argv[i],constraint_table[j])==0){
+            if(!quiet) printf("ERROR: constraint #%d is the same as constraint %d:\n%s\n",
+                     i+1,j+1,argv[i]);
+            return EXIT_ERROR; // other error
+        }
+        ret=minitip_compile_constraint(argv[i],&code,&err);
+        if(ret==MINITIP_SYNTAX){
+            if(!quiet) error_message(argv[i]);
+            return EXIT_SYNTAX; // syntax error
+        }
+        if(ret==MINITIP_TRUE && constraint_no>=max_constraints-1){
+            free_constraint(code);
+            if(!quiet) printf("ERROR: too many constraints (max %d)\n",max_constraints);
+            return EXIT_ERROR; // other error
+        }
+        if(ret!=MINITIP_TRUE ||
+           (constraint_table[constraint_no]=strdup(argv[i]))==NULL){
+            if(ret==MINITIP_TRUE) free_constraint(code);
+            if(!quiet) printf("ERROR: out of memory\n");
+            return EXIT_ERROR; // other error
+        }
+        constraint_code[constraint_no]=code;
+        constraint_no++;
+    }
+    return EXIT_TRUE;
 }
 
 /***********************************************************************
@@ -1874,7 +2058,7 @@ static int check_offline_expression(const char *src, int quiet)
 *    determines the program's exit value. argno is positive.
 */
 static int check_offline(int argc, char *argv[], int quiet)
-{int i,j,keep,parse; char *src;
+{int i; char *src;
     src=argv[0]; while(*src && *src!='=') src++; 
     if(*src=='='){
        src++;
@@ -1889,41 +2073,954 @@ static int check_offline(int argc, char *argv[], int quiet)
           return EXIT_TRUE;
        }
     }
-    keep=0; cmdarg_position=0;
-    for(i=1;i<argc;i++){
-        for(j=0;j<constraint_no;j++) if(strcmp(argv[i],constraint_table[j])==0){
-            if(!quiet) printf("ERROR: constraint #%d is the same as constraint %d:\n%s\n",
-                     i,j+1,argv[i]);
-            return EXIT_ERROR; // other error
+    cmdarg_position=0;
+    if((i=add_offline_constraints(argc-1,argv+1,quiet))!=EXIT_TRUE) return i;
+    return check_offline_expression(argv[0],quiet);
+}
+
+/***********************************************************************
+* Bulk checking (flag -b)
+*
+*    Each line of the input is an expression checked with the same
+*    constraints; empty lines and lines starting with '#' are skipped.
+*    The constraints are parsed and compiled once, and the LP of the
+*    previous line is reused when possible. A regular file is mapped
+*    into memory, other input (such as stdin) is read as a stream;
+*    lines can be of any length. One result line is written for each
+*    expression as soon as it is checked, either tab separated:
+*       <line number> <verdict> <time in ms> <error message>
+*    or as a JSON object (NDJSON) with the same fields. The verdict is
+*    one of TRUE, FALSE, GE (only >= holds), LE (only <= holds),
+*    SYNTAX and ERROR; the time is the total of the phases in
+*    lp_stats.
+*
+*  char *bulk_line(void)
+*    the next input line without the line end, NULL at the end.
+*  int check_bulk(const char *file, int argc, char *argv[],
+*         int workers, int json, int quiet)
+*    check each line of file ("-" is stdin) with argv[0..argc-1] as
+*    constraints, using workers processes in parallel if workers>1.
+*    Returns the largest exit value of the lines, or EXIT_ERROR if the
+*    input cannot be read.
+*/
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static struct {
+    const char *map;		/* the mapped file */
+    size_t len, pos;		/* its length and the next position */
+    FILE *f;			/* or the input stream */
+    char *line;			/* the current line */
+    size_t size;		/* space allocated for it */
+} bulk_in;
+
+static char *bulk_line(void)
+{const char *s,*e; size_t n; ssize_t r;
+    if(bulk_in.f){
+        r=getline(&bulk_in.line,&bulk_in.size,bulk_in.f);
+        if(r<0) return NULL;
+        n=r;
+    } else {
+        if(bulk_in.pos>=bulk_in.len) return NULL;
+        s=bulk_in.map+bulk_in.pos;
+        e=memchr(s,'\n',bulk_in.len-bulk_in.pos);
+        n= e ? (size_t)(e-s) : bulk_in.len-bulk_in.pos;
+        bulk_in.pos += e ? n+1 : n;
+        if(n+1>bulk_in.size){
+            free(bulk_in.line); bulk_in.size=n+1024;
+            if(!(bulk_in.line=malloc(bulk_in.size))){
+                bulk_in.size=0; return NULL;
+            }
         }
-        if(parse_constraint(argv[i],keep)!=PARSE_OK){
-            if(!quiet) error_message(argv[i]);
-            return EXIT_SYNTAX; // syntax error
+        memcpy(bulk_in.line,s,n);
+    }
+    while(n>0 && (bulk_in.line[n-1]=='\n' || bulk_in.line[n-1]=='\r')) n--;
+    bulk_in.line[n]=0;
+    return bulk_in.line;
+}
+
+/* write a string to a JSON or TSV field */
+static void bulk_string(FILE *f, const char *s, int json)
+{   for(;*s;s++){
+        if(json && (*s=='"' || *s=='\\')) fprintf(f,"\\%c",*s);
+        else if((unsigned char)*s<0x20) fprintf(f,json ? "\\u%04x" : " ",*s);
+        else putc(*s,f);
+    }
+}
+
+static void bulk_result(long lineno, const char *verdict, double ms,
+       const char *err, int json)
+{   if(json){
+        printf("{\"line\":%ld,\"verdict\":\"%s\",\"ms\":%.3f,\"error\":\"",
+               lineno,verdict,ms);
+        bulk_string(stdout,err,1); printf("\"}\n");
+    } else {
+        printf("%ld\t%s\t%.3f\t",lineno,verdict,ms);
+        bulk_string(stdout,err,0); printf("\n");
+    }
+    fflush(stdout);
+}
+
+static int bulk_exit(const char *verdict)
+{   return *verdict=='T' ? EXIT_TRUE : *verdict=='S' ? EXIT_SYNTAX :
+           *verdict=='E' ? EXIT_ERROR : EXIT_FALSE;
+}
+
+/* check one expression with or without the constraints; return the
+   verdict, set the error message and the time spent in ms */
+static const char *bulk_check(const char *expr, int with_constraints,
+       int limit, const char **err, double *ms)
+{static const char *verdict[]={"TRUE","FALSE","GE","LE","SYNTAX","ERROR"};
+ int i,ret; struct lp_options_t opt;
+    opt=*lp_options(); opt.timelimit=limit;
+    ret=minitip_check_constraints(with_constraints ? constraint_no : 0,
+            constraint_code,expr,&opt,err,NULL);
+    for(*ms=0.0,i=0;i<STAT_PHASES;i++) *ms+=1000.0*lp_stats.wall[i];
+    return verdict[ret];
+}
+
+/* the next expression to be checked, skipping empty and comment lines;
+   lineno is advanced */
+static char *bulk_expr(long *lineno)
+{char *line,*s;
+    while((line=bulk_line())!=NULL){
+        (*lineno)++;
+        for(s=line;*s==' '||*s=='\t';s++);
+        if(*s && *s!='#') return s;
+    }
+    return NULL;
+}
+
+/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
+/* Parallel workers
+   Workers are forked processes rather than threads so that they can
+   still fork the portfolio and consensus solvers; each has its own
+   copy of the compiled constraints, the Shannon skeleton and the
+   session LP. The parent reads the input and gives the next expression
+   to a worker which has fewer than BULK_AHEAD expressions waiting, so
+   a worker stuck with a hard instance does not hold up the others. A worker
+   reads "<seq>\t<c>\t<limit>\t<expr>" lines from a pipe, where c is 1
+   if the constraints are used and 0 if not, and limit is the LP time
+   limit in seconds for this expression, and answers with lines
+   "<seq>\t<verdict>\t<ms>\t<error>". Results are kept in a ring of
+   BULK_WINDOW entries and written in input order. */
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define BULK_AHEAD	2	/* expressions queued at a worker */
+#define BULK_WINDOW	4096	/* results waiting to be written */
+
+struct bulk_worker_t {
+    pid_t pid;
+    FILE *to;			/* expressions to the worker */
+    int from;			/* results from the worker */
+    char *buf; int len,size;	/* unprocessed part of the results */
+    long seq[BULK_AHEAD];	/* expressions sent, oldest first */
+    int n;			/* number of them */
+};
+static struct bulk_slot_t {
+    long lineno;		/* -1: empty */
+    int done;			/* the result arrived */
+    char verdict[8];
+    double ms;
+    char *err;
+} bulk_ring[BULK_WINDOW];
+
+/* the worker process: check expressions until the pipe is closed */
+static void bulk_worker(int in, int out)
+{FILE *f,*g; char *line=NULL,*s,*e; size_t size=0; const char *verdict,*err;
+ double ms; long limit;
+    f=fdopen(in,"r"); g=fdopen(out,"w");
+    if(!f || !g) _exit(1);
+    while(getline(&line,&size,f)>0){
+        line[strcspn(line,"\n")]=0;
+        if(!(s=strchr(line,'\t')) || !s[1] || s[2]!='\t') continue;
+        *s++=0;
+        limit=strtol(s+2,&e,10);
+        if(e==s+2 || *e!='\t') continue;
+        verdict=bulk_check(e+1,*s=='1',(int)limit,&err,&ms);
+        fprintf(g,"%s\t%s\t%.3f\t",line,verdict,ms);
+        for(;*err;err++) fputc((unsigned char)*err<0x20 ? ' ' : *err,g);
+        fputc('\n',g); fflush(g);
+    }
+    _exit(0);
+}
+
+/* start worker k of n; the child closes the pipes of the other workers
+   and the sockets of the server */
+static void serve_close(void);
+static int bulk_start(struct bulk_worker_t *worker, int k, int n)
+{int i,tochild[2],fromchild[2]; struct bulk_worker_t *w=&worker[k];
+    if(pipe(tochild)) return 1;
+    if(pipe(fromchild)){ close(tochild[0]); close(tochild[1]); return 1; }
+    fflush(stdout);
+    w->pid=fork();
+    if(w->pid<0){
+        close(tochild[0]); close(tochild[1]);
+        close(fromchild[0]); close(fromchild[1]);
+        return 1;
+    }
+    if(w->pid==0){ // child, close the pipes of the other workers
+        for(i=0;i<n;i++) if(i!=k && worker[i].pid>0){
+            close(fileno(worker[i].to)); close(worker[i].from);
         }
-        if(constraint_no>=max_constraints-1){
-            if(!quiet) printf("ERROR: too many constraints (max %d)\n",max_constraints);
-            return EXIT_ERROR; // other error
+        serve_close();
+        close(tochild[1]); close(fromchild[0]);
+        bulk_worker(tochild[0],fromchild[1]);
+    }
+    close(tochild[0]); close(fromchild[1]);
+    w->to=fdopen(tochild[1],"w"); w->from=fromchild[0];
+    w->buf=NULL; w->len=w->size=0; w->n=0;
+    return w->to==NULL;
+}
+
+/* a result from a worker */
+typedef void bulk_done_t(long seq, const char *verdict, double ms, const char *err);
+
+/* keep the result in the ring */
+static void bulk_ring_done(long seq, const char *verdict, double ms, const char *err)
+{struct bulk_slot_t *r=&bulk_ring[seq%BULK_WINDOW];
+    snprintf(r->verdict,sizeof(r->verdict),"%s",verdict);
+    r->ms=ms; r->err=strdup(err); r->done=1;
+}
+
+/* parse the result line of a worker */
+static void bulk_store(struct bulk_worker_t *w, char *line, bulk_done_t *done)
+{long seq; char *s,*t; double ms;
+    seq=strtol(line,&s,10);
+    if(w->n==0 || seq!=w->seq[0] || *s!='\t') return;
+    w->n--; memmove(w->seq,w->seq+1,w->n*sizeof(long));
+    t=strchr(++s,'\t'); if(!t) return;
+    *t++=0; ms=strtod(t,&t);
+    done(seq,s,ms,*t=='\t' ? t+1 : "");
+}
+
+/* read the results available from worker w; return 1 if it is gone */
+static int bulk_read(struct bulk_worker_t *w, bulk_done_t *done)
+{int n; char *s,*e;
+    if(w->size-w->len<4096){
+        w->size = w->size ? 2*w->size : 8192;
+        if(!(s=realloc(w->buf,w->size))) return 1;
+        w->buf=s;
+    }
+    n=read(w->from,w->buf+w->len,w->size-w->len-1);
+    if(n<=0){ // the worker died, its expressions failed
+        for(;w->n>0;w->n--)
+            done(w->seq[w->n-1],"ERROR",0.0,"the worker process died");
+        return 1;
+    }
+    w->len+=n; w->buf[w->len]=0;
+    for(s=w->buf;(e=strchr(s,'\n'))!=NULL;s=e+1){
+        *e=0; bulk_store(w,s,done);
+    }
+    w->len-= s-w->buf; memmove(w->buf,s,w->len);
+    return 0;
+}
+
+static int check_parallel(int workers, int json, int quiet)
+{int i,k,ret,alive; long lineno,seq,next; char *expr; struct bulk_slot_t *r;
+ struct bulk_worker_t *w; struct pollfd *pfd; void (*oldpipe)(int);
+    w=calloc(workers,sizeof(struct bulk_worker_t));
+    pfd=calloc(workers,sizeof(struct pollfd));
+    if(!w || !pfd){
+        if(w) free(w);
+        if(pfd) free(pfd);
+        if(!quiet) printf("ERROR: out of memory\n");
+        return EXIT_ERROR;
+    }
+    oldpipe=signal(SIGPIPE,SIG_IGN);
+    for(alive=0;alive<workers && bulk_start(w,alive,workers)==0;alive++);
+    for(i=0;i<BULK_WINDOW;i++) bulk_ring[i].lineno=-1;
+    ret= alive ? EXIT_TRUE : EXIT_ERROR;
+    if(!alive && !quiet) printf("ERROR: cannot start worker processes\n");
+    lineno=0; seq=0; next=0; expr=alive ? bulk_expr(&lineno) : NULL;
+    while(expr || next<seq){
+        /* hand out expressions to workers with free places */
+        while(expr && seq-next<BULK_WINDOW){
+            for(k=-1,i=0;i<workers;i++) if(w[i].pid>0 && w[i].n<BULK_AHEAD &&
+                    (k<0 || w[i].n<w[k].n)) k=i;
+            if(k<0) break;
+            r=&bulk_ring[seq%BULK_WINDOW];
+            r->lineno=lineno; r->done=0; r->err=NULL;
+            w[k].seq[w[k].n++]=seq;
+            fprintf(w[k].to,"%ld\t1\t%d\t%s\n",seq,get_param("timelimit"),expr);
+            fflush(w[k].to);
+            seq++; expr=bulk_expr(&lineno);
+        }
+        /* write the results in order */
+        while(next<seq && bulk_ring[next%BULK_WINDOW].done){
+            r=&bulk_ring[next%BULK_WINDOW];
+            if(!quiet) bulk_result(r->lineno,r->verdict,r->ms,r->err ? r->err : "",json);
+            if(bulk_exit(r->verdict)>ret) ret=bulk_exit(r->verdict);
+            if(r->err) free(r->err);
+            r->lineno=-1; next++;
+        }
+        if(next==seq && !expr) break;
+        /* wait for results */
+        for(k=0,i=0;i<workers;i++) if(w[i].pid>0){
+            pfd[k].fd=w[i].from; pfd[k].events=POLLIN; k++;
+        }
+        if(k==0){ // all workers died
+            for(;expr;expr=bulk_expr(&lineno)){
+                if(!quiet) bulk_result(lineno,"ERROR",0.0,"no worker process",json);
+                ret=EXIT_ERROR;
+            }
+            continue;
+        }
+        if(poll(pfd,k,-1)<0) continue;
+        for(k=0,i=0;i<workers;i++) if(w[i].pid>0){
+            if(pfd[k].revents && bulk_read(&w[i],bulk_ring_done)){
+                fclose(w[i].to); close(w[i].from);
+                waitpid(w[i].pid,NULL,0); w[i].pid=0;
+            }
+            k++;
         }
-        constraint_table[constraint_no]=argv[i];
-        constraint_no++;
-        keep=1;
     }
-    parse=parse_entropy(argv[0],keep);
-    if(parse==PARSE_ERR){
-        if(!quiet) error_message(argv[0]);
-        return EXIT_SYNTAX; // syntax error
+    for(i=0;i<workers;i++) if(w[i].pid>0){
+        fclose(w[i].to); close(w[i].from);
+        waitpid(w[i].pid,NULL,0);
     }
-    switch(parse){
-      case PARSE_EQ:
-        if(!quiet) printf(res_TRUEEQ "\n");
-        return EXIT_TRUE;
-      case PARSE_GE:
-        if(!quiet) printf(res_TRUEGE "\n");
-        return EXIT_TRUE;
-      default:
-        break;
+    for(i=0;i<workers;i++) if(w[i].buf) free(w[i].buf);
+    free(w); free(pfd);
+    signal(SIGPIPE,oldpipe);
+    return ret;
+}
+
+static int check_bulk(const char *file, int argc, char *argv[], int workers,
+       int json, int quiet)
+{int fd,ret,r; long lineno; struct stat st; char *expr; const char *verdict,*err;
+ double ms;
+    if(cert_name){
+        if(!quiet) printf("ERROR: flag '-C' cannot be used with '-b'\n");
+        return EXIT_ERROR;
     }
-    return check_offline_expression(argv[0],quiet);
+    cmdarg_position=0;
+    if((ret=add_offline_constraints(argc,argv,quiet))!=EXIT_TRUE) return ret;
+    memset(&bulk_in,0,sizeof(bulk_in));
+    if(strcmp(file,"-")==0){
+        bulk_in.f=stdin;
+    } else {
+        if((fd=open(file,O_RDONLY))<0 || fstat(fd,&st)!=0){
+            if(!quiet) printf("ERROR: cannot open the input file %s\n",file);
+            if(fd>=0) close(fd);
+            return EXIT_ERROR;
+        }
+        if(!S_ISREG(st.st_mode)){ // not a file, read it as a stream
+            bulk_in.f=fdopen(fd,"r");
+        } else if(st.st_size>0){
+            bulk_in.map=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+            close(fd);
+            if(bulk_in.map==MAP_FAILED){
+                if(!quiet) printf("ERROR: cannot read the input file %s\n",file);
+                return EXIT_ERROR;
+            }
+            bulk_in.len=st.st_size;
+            madvise((void*)bulk_in.map,bulk_in.len,MADV_SEQUENTIAL);
+        } else close(fd);
+    }
+    if(workers>1){
+        ret=check_parallel(workers,json,quiet);
+    } else for(lineno=0;(expr=bulk_expr(&lineno))!=NULL;){
+        verdict=bulk_check(expr,1,get_param("timelimit"),&err,&ms);
+        if(!quiet) bulk_result(lineno,verdict,ms,err,json);
+        if((r=bulk_exit(verdict))>ret) ret=r;
+    }
+    if(bulk_in.map) munmap((void*)bulk_in.map,bulk_in.len);
+    if(bulk_in.f && bulk_in.f!=stdin) fclose(bulk_in.f);
+    if(bulk_in.line) free(bulk_in.line);
+    return ret;
+}
+
+/***********************************************************************
+* Server mode (flags --serve and --client)
+*
+*    minitip --serve <socket> [constraint1] [constraint2] ...
+*    listens on a Unix domain socket. Macros and constraints are set
+*    up once from the rc file, the flags -m and the arguments; checks
+*    are done by a pool of worker processes (flag -j, default one)
+*    which keep their LPs between requests. A client sends requests
+*    one per line, either
+*       [<id><tab>][check |xcheck ]<expression>
+*    or as a JSON object
+*       {"id":"<id>","check":"<expression>","timeout":<seconds>}
+*    "xcheck" checks without the constraints. Empty lines and lines
+*    starting with '#' are skipped. The answer to a request is a line
+*       <id> <verdict> <time in ms> <error message>
+*    with tab separated fields as for the flag -b, or a JSON object
+*    with the fields id, verdict, ms and error for JSON requests.
+*    Without an id the number of the request in the connection is
+*    used. Answers are sent as the checks finish, and not necessarily
+*    in the order of the requests. The LP time limit of a check is the
+*    timelimit parameter unless the request sets it (at most
+*    minitip_MAX_TIMELIMIT seconds); a worker still running the check
+*    SERVE_GRACE seconds after this limit is killed and restarted. In
+*    both cases the answer is ERROR.
+*
+*    minitip --client <socket> [expression]
+*    sends the expression to the server and prints the verdict as
+*    minitip does, and sets the exit value. Without an expression,
+*    request lines are read from stdin and the answer lines are
+*    written to stdout.
+*
+*  void serve_close(void)
+*    close the sockets of the server and restore the signal handlers;
+*    called in the worker processes.
+*  int serve(const char *path, int argc, char *argv[], int workers,
+*         int quiet)
+*    serve requests on the socket path with the constraints in
+*    argv[0..argc-1] until SIGINT or SIGTERM.
+*  int client(const char *path, int argc, char *argv[], int quiet)
+*    check argv[0] by the server, or pass stdin to it.
+*/
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define SERVE_QUEUE	4096	/* requests waiting for a worker */
+#define SERVE_MAXLINE	(16<<20) /* longest request line */
+#define SERVE_GRACE	1.0	/* seconds after the LP time limit */
+
+struct serve_req_t {
+    int conn, gen;		/* the connection and its generation */
+    char *id;			/* request id */
+    char *expr;			/* the expression to be checked */
+    int constr;			/* use the constraints */
+    int json;			/* answer in JSON */
+    double limit;		/* time limit in seconds */
+    long seq;			/* sequence number at the worker */
+    double deadline;		/* when the worker is killed */
+};
+static struct serve_conn_t {
+    FILE *out;			/* answers; NULL if the slot is free */
+    int fd;			/* the socket */
+    int gen;			/* changes when the slot is reused */
+    int broken;			/* writing failed */
+    char *buf; int len,size;	/* unprocessed input */
+    long requests;		/* requests received */
+} serve_conn[minitip_MAX_CLIENTS];
+static int serve_fd=-1;		/* the listening socket */
+static struct serve_req_t *serve_queue[SERVE_QUEUE]; /* waiting requests */
+static int serve_head=0,serve_n=0;
+static struct bulk_worker_t *serve_w; /* the workers */
+static struct serve_req_t **serve_busy; /* the request at each worker */
+static int serve_workers;
+static volatile sig_atomic_t serve_stop=0;
+
+static void serve_close(void)
+{int i;
+    if(serve_fd<0) return;
+    signal(SIGINT,SIG_DFL); signal(SIGTERM,SIG_DFL);
+    close(serve_fd);
+    for(i=0;i<minitip_MAX_CLIENTS;i++) if(serve_conn[i].out){
+        close(fileno(serve_conn[i].out)); close(serve_conn[i].fd);
+    }
+}
+
+static double serve_now(void)
+{struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+
+static void serve_signal(UNUSED int sig)
+{   serve_stop=1; }
+
+static void serve_free(struct serve_req_t *r)
+{   if(r->id) free(r->id);
+    if(r->expr) free(r->expr);
+    free(r);
+}
+
+/* send the answer to the client if it is still connected */
+static void serve_answer(struct serve_req_t *r, const char *verdict,
+       double ms, const char *err)
+{struct serve_conn_t *c=&serve_conn[r->conn];
+    if(!c->out || c->gen!=r->gen || c->broken) return;
+    if(r->json){
+        fprintf(c->out,"{\"id\":\""); bulk_string(c->out,r->id,1);
+        fprintf(c->out,"\",\"verdict\":\"%s\",\"ms\":%.3f,\"error\":\"",verdict,ms);
+        bulk_string(c->out,err,1); fprintf(c->out,"\"}\n");
+    } else {
+        bulk_string(c->out,r->id,0);
+        fprintf(c->out,"\t%s\t%.3f\t",verdict,ms);
+        bulk_string(c->out,err,0); fprintf(c->out,"\n");
+    }
+    if(fflush(c->out)!=0) c->broken=1;
+}
+
+/* a result from a worker process */
+static void serve_done(long seq, const char *verdict, double ms, const char *err)
+{int k; struct serve_req_t *r;
+    for(k=0;k<serve_workers && (!serve_busy[k] || serve_busy[k]->seq!=seq);k++);
+    if(k==serve_workers) return;
+    r=serve_busy[k];
+    serve_answer(r,verdict,ms,err);
+    serve_free(r); serve_busy[k]=NULL;
+}
+
+/* stop worker k */
+static void serve_stop_worker(int k)
+{struct bulk_worker_t *w=&serve_w[k];
+    fclose(w->to); close(w->from);
+    kill(w->pid,SIGKILL); waitpid(w->pid,NULL,0);
+    w->pid=0; w->len=0; w->n=0;
+}
+
+/* parse a JSON string at *p in place; return it or NULL on error */
+static char *json_str(char **p)
+{char *s=*p,*t,*r; int i,v;
+    if(*s!='"') return NULL;
+    r=t=++s;
+    while(*s!='"'){
+        if(!*s) return NULL;
+        if(*s!='\\'){ *t++=*s++; continue; }
+        s++;
+        switch(*s){
+          case 0:   return NULL;
+          case 'n': case 'r': case 't': case 'b': case 'f':
+                    *t++=' '; break;
+          case 'u': for(v=0,i=1;i<=4;i++){
+                        if(!isxdigit((unsigned char)s[i])) return NULL;
+                        v=16*v+(isdigit((unsigned char)s[i]) ? s[i]-'0' :
+                                tolower((unsigned char)s[i])-'a'+10);
+                    }
+                    *t++= 0x20<=v && v<0x7f ? v : ' '; s+=4; break;
+          default:  *t++=*s; break;
+        }
+        s++;
+    }
+    *t=0; *p=s+1;
+    return r;
+}
+
+/* fill the request from a JSON object; return NULL or an error */
+static const char *serve_json(char *s, struct serve_req_t *r)
+{char *key,*val,*t,c;
+    for(s++;;){
+        while(isspace((unsigned char)*s)) s++;
+        if(*s=='}') return NULL;
+        if(!(key=json_str(&s))) return "bad JSON key";
+        while(isspace((unsigned char)*s)) s++;
+        if(*s!=':') return "':' is missing after a JSON key";
+        for(s++;isspace((unsigned char)*s);s++);
+        if(*s=='"'){
+            if(!(val=json_str(&s))) return "bad JSON string";
+            t=NULL; c=0;
+        } else {
+            val=s; t=s+strcspn(s,",} \t"); c=*t; *t=0;
+        }
+        if(strcmp(key,"id")==0){
+            if(r->id) free(r->id);
+            r->id=strdup(val);
+        } else if(strcmp(key,"check")==0 || strcmp(key,"xcheck")==0){
+            if(r->expr) free(r->expr);
+            r->expr=strdup(val); r->constr= *key=='c';
+        } else if(strcmp(key,"timeout")==0){
+            r->limit=strtod(val,NULL);
+        }
+        if(t){ *t=c; s=t; }
+        while(isspace((unsigned char)*s)) s++;
+        if(*s==',') s++;
+        else if(*s!='}') return "',' or '}' is expected in the JSON object";
+    }
+}
+
+/* process a request line of connection c */
+static void serve_request(int c, char *line)
+{struct serve_conn_t *conn=&serve_conn[c]; struct serve_req_t *r;
+ const char *err; char *s,num[30];
+    while(*line==' ' || *line=='\t') line++;
+    if(!*line || *line=='#') return;
+    conn->requests++;
+    r=calloc(1,sizeof(struct serve_req_t));
+    if(!r){ conn->broken=1; return; }
+    r->conn=c; r->gen=conn->gen; r->constr=1;
+    r->limit=get_param("timelimit");
+    err=NULL;
+    if(*line=='{'){
+        r->json=1; err=serve_json(line,r);
+        if(!err && !r->expr) err="no \"check\" or \"xcheck\" in the request";
+    } else {
+        if((s=strchr(line,'\t'))){ *s=0; r->id=strdup(line); line=s+1; }
+        if(strncmp(line,"check",5)==0 && (line[5]==' '||line[5]=='\t')) line+=6;
+        else if(strncmp(line,"xcheck",6)==0 && (line[6]==' '||line[6]=='\t')){
+            line+=7; r->constr=0;
+        }
+        r->expr=strdup(line);
+    }
+    if(!r->id){ sprintf(num,"%ld",conn->requests); r->id=strdup(num); }
+    if(!err && (!r->id || !r->expr)) err="out of memory";
+    if(!err && serve_n>=SERVE_QUEUE) err="too many requests are waiting";
+    if(err){
+        serve_answer(r,"ERROR",0.0,err); serve_free(r);
+        return;
+    }
+    if(r->limit<=0.0) r->limit=get_param("timelimit");
+    if(r->limit>minitip_MAX_TIMELIMIT) r->limit=minitip_MAX_TIMELIMIT;
+    serve_queue[(serve_head+serve_n)%SERVE_QUEUE]=r; serve_n++;
+}
+
+/* read from connection c; return 1 if it is to be closed */
+static int serve_input(int c)
+{struct serve_conn_t *conn=&serve_conn[c]; int n; char *s,*e;
+    if(conn->size-conn->len<4096){
+        if(conn->size>SERVE_MAXLINE) return 1;
+        n= conn->size ? 2*conn->size : 8192;
+        if(!(s=realloc(conn->buf,n))) return 1;
+        conn->buf=s; conn->size=n;
+    }
+    n=read(conn->fd,conn->buf+conn->len,conn->size-conn->len-1);
+    if(n<=0) return 1;
+    conn->len+=n; conn->buf[conn->len]=0;
+    for(s=conn->buf;(e=strchr(s,'\n'))!=NULL;s=e+1){
+        *e=0; if(e>s && e[-1]=='\r') e[-1]=0;
+        serve_request(c,s);
+    }
+    conn->len-= s-conn->buf; memmove(conn->buf,s,conn->len);
+    return conn->broken;
+}
+
+static void serve_accept(void)
+{int i,fd; struct timeval tv;
+    if((fd=accept(serve_fd,NULL,NULL))<0) return;
+    for(i=0;i<minitip_MAX_CLIENTS && serve_conn[i].out;i++);
+    if(i==minitip_MAX_CLIENTS){ close(fd); return; }
+    /* a client not reading its answers cannot stop the server */
+    tv.tv_sec=5; tv.tv_usec=0;
+    setsockopt(fd,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv));
+    serve_conn[i].out=fdopen(dup(fd),"w");
+    if(!serve_conn[i].out){ close(fd); return; }
+    serve_conn[i].fd=fd; serve_conn[i].broken=0;
+    serve_conn[i].len=0; serve_conn[i].requests=0;
+}
+
+static void serve_disconnect(int c)
+{struct serve_conn_t *conn=&serve_conn[c];
+    fclose(conn->out); close(conn->fd);
+    conn->out=NULL; conn->gen++;
+    if(conn->buf){ free(conn->buf); conn->buf=NULL; }
+    conn->len=conn->size=0;
+}
+
+static int serve(const char *path, int argc, char *argv[], int workers,
+       int quiet)
+{int i,k,n,ret,timeout; long seq; double now,t; struct sockaddr_un addr;
+ struct stat st; struct pollfd *pfd; struct serve_req_t *r;
+    if(cert_name){
+        if(!quiet) printf("ERROR: flag '-C' cannot be used with '--serve'\n");
+        return EXIT_ERROR;
+    }
+    cmdarg_position=0;
+    if((ret=add_offline_constraints(argc,argv,quiet))!=EXIT_TRUE) return ret;
+    memset(&addr,0,sizeof(addr)); addr.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(addr.sun_path)){
+        if(!quiet) printf("ERROR: socket name %s is too long\n",path);
+        return EXIT_ERROR;
+    }
+    strcpy(addr.sun_path,path);
+    if(stat(path,&st)==0 && S_ISSOCK(st.st_mode)) unlink(path);
+    serve_fd=socket(AF_UNIX,SOCK_STREAM,0);
+    if(serve_fd<0 || bind(serve_fd,(struct sockaddr*)&addr,sizeof(addr))!=0
+       || listen(serve_fd,minitip_MAX_CLIENTS)!=0){
+        if(!quiet) printf("ERROR: cannot listen on socket %s\n",path);
+        if(serve_fd>=0) close(serve_fd);
+        serve_fd=-1; return EXIT_ERROR;
+    }
+    serve_workers=workers;
+    serve_w=calloc(workers,sizeof(struct bulk_worker_t));
+    serve_busy=calloc(workers,sizeof(struct serve_req_t *));
+    pfd=calloc(1+workers+minitip_MAX_CLIENTS,sizeof(struct pollfd));
+    if(!serve_w || !serve_busy || !pfd){
+        if(!quiet) printf("ERROR: out of memory\n");
+        close(serve_fd); unlink(path); return EXIT_ERROR;
+    }
+    signal(SIGPIPE,SIG_IGN);
+    signal(SIGINT,serve_signal); signal(SIGTERM,serve_signal);
+    if(!quiet){
+        printf("minitip: serving on %s with %d worker%s\n",path,workers,
+               workers>1 ? "s" : "");
+        fflush(stdout);
+    }
+    for(seq=0;!serve_stop;){
+        /* start missing workers, give out requests */
+        for(n=0,k=0;k<workers;k++){
+            if(serve_w[k].pid<=0 && bulk_start(serve_w,k,workers)) serve_w[k].pid=0;
+            if(serve_w[k].pid<=0) continue;
+            n++;
+            if(serve_busy[k] || serve_n==0) continue;
+            r=serve_queue[serve_head]; serve_head=(serve_head+1)%SERVE_QUEUE;
+            serve_n--;
+            r->seq=++seq; serve_w[k].seq[0]=seq; serve_w[k].n=1;
+            r->deadline=serve_now()+r->limit+SERVE_GRACE; serve_busy[k]=r;
+            fprintf(serve_w[k].to,"%ld\t%d\t%d\t%s\n",seq,r->constr,
+                (int)r->limit+(r->limit>(int)r->limit),r->expr);
+            fflush(serve_w[k].to);
+        }
+        for(;n==0 && serve_n>0;serve_n--){
+            r=serve_queue[serve_head]; serve_head=(serve_head+1)%SERVE_QUEUE;
+            serve_answer(r,"ERROR",0.0,"no worker process"); serve_free(r);
+        }
+        /* wait for a connection, a request, a result or a deadline */
+        now=serve_now(); timeout=-1;
+        pfd[0].fd= serve_fd; pfd[0].events=POLLIN;
+        for(k=0;k<workers;k++){
+            pfd[1+k].fd= serve_w[k].pid>0 ? serve_w[k].from : -1;
+            pfd[1+k].events=POLLIN;
+            if((r=serve_busy[k])!=NULL){
+                t= r->deadline>now ? 1000.0*(r->deadline-now)+1 : 0;
+                if(timeout<0 || t<timeout) timeout=(int)t;
+            }
+        }
+        for(i=0;i<minitip_MAX_CLIENTS;i++){
+            pfd[1+workers+i].fd= serve_conn[i].out && serve_n<SERVE_QUEUE ?
+                   serve_conn[i].fd : -1;
+            pfd[1+workers+i].events=POLLIN;
+        }
+        if(poll(pfd,1+workers+minitip_MAX_CLIENTS,timeout)<0){
+            if(errno==EINTR) continue;
+            break;
+        }
+        now=serve_now();
+        for(k=0;k<workers;k++) if(serve_w[k].pid>0){
+            if(pfd[1+k].revents && bulk_read(&serve_w[k],serve_done)){
+                serve_stop_worker(k);
+            } else if((r=serve_busy[k])!=NULL && r->deadline<=now){
+                serve_stop_worker(k);
+                serve_answer(r,"ERROR",1000.0*r->limit,"time limit exceeded");
+                serve_free(r); serve_busy[k]=NULL;
+            }
+        }
+        if(pfd[0].revents) serve_accept();
+        for(i=0;i<minitip_MAX_CLIENTS;i++) if(serve_conn[i].out){
+            if((pfd[1+workers+i].revents && serve_input(i)) || serve_conn[i].broken)
+                serve_disconnect(i);
+        }
+    }
+    /* stopped by a signal */
+    for(k=0;k<workers;k++){
+        if(serve_w[k].pid>0) serve_stop_worker(k);
+        if(serve_busy[k]) serve_free(serve_busy[k]);
+        if(serve_w[k].buf) free(serve_w[k].buf);
+    }
+    for(;serve_n>0;serve_n--){
+        serve_free(serve_queue[serve_head]); serve_head=(serve_head+1)%SERVE_QUEUE;
+    }
+    for(i=0;i<minitip_MAX_CLIENTS;i++) if(serve_conn[i].out) serve_disconnect(i);
+    close(serve_fd); serve_fd=-1; unlink(path);
+    free(serve_w); free(serve_busy); free(pfd);
+    return EXIT_TRUE;
+}
+
+/* connect to the server at path; return the socket or -1 */
+static int client_connect(const char *path)
+{int fd; struct sockaddr_un addr;
+    memset(&addr,0,sizeof(addr)); addr.sun_family=AF_UNIX;
+    if(strlen(path)>=sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path,path);
+    if((fd=socket(AF_UNIX,SOCK_STREAM,0))<0) return -1;
+    if(connect(fd,(struct sockaddr*)&addr,sizeof(addr))!=0){
+        close(fd); return -1;
+    }
+    return fd;
+}
+
+/* send a request and read the answer line; NULL if the connection
+   was closed */
+static char *client_request(FILE *to, FILE *from, const char *req,
+       char **answer, size_t *size)
+{   fprintf(to,"%s\n",req); fflush(to);
+    if(getline(answer,size,from)<=0) return NULL;
+    (*answer)[strcspn(*answer,"\r\n")]=0;
+    return *answer;
+}
+
+/* the verdict in a TSV or JSON answer, and the error of a TSV answer */
+static const char *client_verdict(char *answer, const char **err)
+{char *s,*t;
+    *err="bad answer from the server";
+    if(*answer=='{')
+        return (s=strstr(answer,"\"verdict\":\"")) ? s+11 : "ERROR";
+    if(!(s=strchr(answer,'\t'))) return "ERROR";
+    s++; t=strchr(s,'\t');
+    *err= t && (t=strchr(t+1,'\t')) ? t+1 : "";
+    return s;
+}
+
+static int client(const char *path, int argc, char *argv[], int quiet)
+{int fd,ret,r; FILE *to,*from; char *line,*req,*answer,*s; size_t size,asize;
+ const char *verdict,*err;
+    if(argc>1){
+        if(!quiet) printf("ERROR: the constraints are set by the server\n");
+        return EXIT_ERROR;
+    }
+    if((fd=client_connect(path))<0){
+        if(!quiet) printf("ERROR: cannot connect to the server at %s\n",path);
+        return EXIT_ERROR;
+    }
+    to=fdopen(dup(fd),"w"); from=fdopen(fd,"r");
+    if(!to || !from){
+        if(!quiet) printf("ERROR: out of memory\n");
+        return EXIT_ERROR;
+    }
+    signal(SIGPIPE,SIG_IGN);
+    answer=NULL; asize=0; ret=EXIT_TRUE;
+    if(argc==1){ // one expression, print the verdict
+        if(!(req=malloc(strlen(argv[0])+10))) return EXIT_ERROR;
+        strcpy(req,"1\tcheck ");
+        for(s=req+8,line=argv[0];*line;line++)
+            *s++= (unsigned char)*line<0x20 ? ' ' : *line;
+        *s=0;
+        if(client_request(to,from,req,&answer,&asize)){
+            verdict=client_verdict(answer,&err);
+        } else {
+            verdict="ERROR"; err="the server closed the connection";
+        }
+        ret=bulk_exit(verdict);
+        if(!quiet){
+            printf("%s\n",argv[0]);
+            if(strncmp(verdict,"TRUE",4)==0) printf(res_TRUE "\n");
+            else if(strncmp(verdict,"FALSE",5)==0) printf(res_FALSE "\n");
+            else if(strncmp(verdict,"GE",2)==0) printf(res_ONLYGE "\n");
+            else if(strncmp(verdict,"LE",2)==0) printf(res_ONLYLE "\n");
+            else printf("ERROR: %s\n",err);
+        }
+        free(req);
+    } else { // pass the lines of stdin
+        line=NULL; size=0;
+        while(getline(&line,&size,stdin)>0){
+            line[strcspn(line,"\r\n")]=0;
+            for(s=line;*s==' '||*s=='\t';s++);
+            if(!*s || *s=='#') continue; // no answer to these
+            if(!client_request(to,from,line,&answer,&asize)){
+                if(!quiet) printf("ERROR: the server closed the connection\n");
+                ret=EXIT_ERROR; break;
+            }
+            if(!quiet){ printf("%s\n",answer); fflush(stdout); }
+            if((r=bulk_exit(client_verdict(answer,&err)))>ret) ret=r;
+        }
+        if(line) free(line);
+    }
+    if(answer) free(answer);
+    fclose(to); fclose(from);
+    return ret;
+}
+
+/***********************************************************************
+* Pipe mode (flag --pipe)
+*
+*    Commands are read from stdin line by line without readline, and
+*    the state (macros, constraints, the LP) is kept from line to
+*    line. The commands are
+*       check <expr>, test <expr>, xcheck <expr>, <relation>,
+*       add <constraint>, del <n> | all, macro [add] <definition>,
+*       quit
+*    optionally preceded by "<id><tab>", where the id is a word which
+*    is not a command. Empty lines and lines
+*    starting with '#' are skipped. Each command writes exactly one
+*    line as -b does, flushed at once: the id (or the line number),
+*    the verdict, the time in ms and the error message separated by
+*    tabs, or as a JSON object with the flag -J. The verdict of add,
+*    del and macro is OK, SYNTAX or ERROR.
+*
+*  int pipe_commands(int argc, char *argv[], int json)
+*    execute the commands with the constraints in argv[0..argc-1]
+*    added first. Returns the largest exit value of the lines.
+*/
+static void pipe_result(const char *id, const char *verdict, double ms,
+       const char *err, int json)
+{   if(json){
+        printf("{\"id\":\""); bulk_string(stdout,id,1);
+        printf("\",\"verdict\":\"%s\",\"ms\":%.3f,\"error\":\"",verdict,ms);
+        bulk_string(stdout,err,1); printf("\"}\n");
+    } else {
+        bulk_string(stdout,id,0); printf("\t%s\t%.3f\t",verdict,ms);
+        bulk_string(stdout,err,0); printf("\n");
+    }
+    fflush(stdout);
+}
+
+/* the syntax error in syntax_error */
+static const char *pipe_syntax(void)
+{   return syntax_error.harderrstr ? syntax_error.harderrstr : syntax_error.softerrstr; }
+
+/* execute one command line; return the verdict and set the error */
+static const char *pipe_command(char *text, const char **err, double *ms)
+{int cmd,len,ret; const char *f; struct constraint_t *code;
+    *err=""; *ms=0.0;
+    cmd=which_command(text,&len);
+    if(cmd<0){ // a relation to be checked
+        for(len=0;text[len] && text[len]!='=';len++);
+        if(text[len]=='=' && text[len+1]!='=')
+            return bulk_check(text,1,get_param("timelimit"),err,ms);
+        *err="unknown command"; return "ERROR";
+    }
+    f=commands[cmd].name; text+=len;
+    if(strcmp(f,"check")==0 || strcmp(f,"test")==0)
+        return bulk_check(text,1,get_param("timelimit"),err,ms);
+    if(strcmp(f,"xcheck")==0)
+        return bulk_check(text,0,get_param("timelimit"),err,ms);
+    if(strcmp(f,"add")==0){
+        for(len=0;len<constraint_no;len++)
+            if(strcmp(text,constraint_table[len])==0) return "OK";
+        if((ret=minitip_compile_constraint(text,&code,err))==MINITIP_SYNTAX)
+            return "SYNTAX";
+        if(ret!=MINITIP_TRUE) return "ERROR";
+        if(constraint_no>=max_constraints-1){
+            free_constraint(code); *err="too many constraints"; return "ERROR";
+        }
+        if((constraint_table[constraint_no]=strdup(text))==NULL){
+            free_constraint(code); *err="out of memory"; return "ERROR";
+        }
+        constraint_code[constraint_no]=code;
+        constraint_no++; invalidate_lp();
+        return "OK";
+    }
+    if(strcmp(f,"del")==0){
+        if(strcmp(text,"all")!=0 && (read_number(text,&len)==0 ||
+           text[read_number(text,&len)] || len<1 || len>constraint_no)){
+            *err="specify a constraint number or 'all'"; return "ERROR";
+        }
+        com_del(text,text);
+        return "OK";
+    }
+    if(strcmp(f,"macro")==0){
+        if(strncmp(text,"add",3)==0 && (text[3]==' '||text[3]=='\t'))
+            for(text+=4;*text==' '||*text=='\t';text++);
+        if(parse_macro_definition(text)!=PARSE_OK){ *err=pipe_syntax(); return "SYNTAX"; }
+        return "OK";
+    }
+    *err="this command is not available in pipe mode"; return "ERROR";
+}
+
+static int pipe_commands(int argc, char *argv[], int json)
+{int ret,r,len; long lineno; char *text,*s,*id,num[30]; const char *verdict,*err;
+ double ms; size_t size;
+    cmdarg_position=0;
+    if((ret=add_offline_constraints(argc,argv,0))!=EXIT_TRUE) return ret;
+    text=NULL; size=0;
+    for(lineno=1;getline(&text,&size,stdin)>0;lineno++){
+        text[strcspn(text,"\r\n")]=0;
+        for(s=text;*s==' '||*s=='\t';s++);
+        if(!*s || *s=='#') continue;
+        /* the id is a word followed by a tab */
+        sprintf(num,"%ld",lineno); id=num;
+        len=strcspn(s," \t=<>");
+        if(len>0 && s[len]=='\t' && which_command(s,&r)<0){
+            s[len]=0; id=s; s+=len+1;
+        }
+        while(*s==' '||*s=='\t') s++;
+        for(r=strlen(s);r>0 && (s[r-1]==' '||s[r-1]=='\t');r--) s[r-1]=0;
+        if(strcmp(s,"quit")==0) break;
+        verdict=pipe_command(s,&err,&ms);
+        pipe_result(id,verdict,ms,err,json);
+        if(*verdict!='O' && (r=bulk_exit(verdict))>ret) ret=r;
+    }
+    if(text) free(text);
+    return ret;
 }
 
 /***********************************************************************
@@ -2004,12 +3101,28 @@ inline static void short_help(void){printf(
 "    minitip [flags]\n"
 "for interactive usage, or\n"
 "    minitip [flags] <expression> [constraint1] [constraint2] ... \n"
+"or\n"
+"    minitip [flags] -b <file> [constraint1] [constraint2] ... \n"
+"or\n"
+"    minitip [flags] --serve <socket> [constraint1] [constraint2] ... \n"
+"    minitip --client <socket> [expression]\n"
+"or\n"
+"    minitip [flags] --pipe [constraint1] [constraint2] ... \n"
 "Flags:\n"
 "   -h         -- this help\n"
 "   -s         -- start using minimal syntax style (default, same as '-s,')\n"
 "   -s<chr>    -- minimal style, use <chr> as the separator character\n"
 "   -S         -- start using full syntax style\n"
 "   -q         -- quiet, just check, don't print anything\n"
+"   -C <file>  -- write the certificate of the result to <file>\n"
+"   -b <file>  -- check each line of <file> ('-' is stdin), write one result line\n"
+"   -J         -- write the results of '-b' as JSON objects instead of TSV\n"
+"   -j <N>     -- check the lines of '-b' in N parallel processes (0: one per CPU)\n"
+"   --serve <socket> -- answer check requests on a Unix socket, N workers with '-j'\n"
+"   --client <socket> -- send the expression, or stdin lines, to the server\n"
+"   --pipe     -- read commands from stdin, write one result line for each\n"
+"   -T         -- print timing and LP size statistics of each check\n"
+"   -R <seed>  -- seed of the random generator, for reproducible runs\n"
 "   -e         -- last flag, use when the expression starts with '-'\n"
 "   -f <file>  -- use <file> as the command history file (default: '" DEFAULT_HISTORY_FILE "')\n"
 "   -c <file>  -- use <file> as the config file (default: '" DEFAULT_RC_FILE "')\n"
@@ -2025,12 +3138,13 @@ inline static void short_help(void){printf(
 }
 
 int main(int argc, char *argv[])
-{char *line; int i; int quietflag, endargs, styleset, rcfile;
- char *histfile; syntax_style_t mi_style=minitip_INITIAL_STYLE; 
+{char *line; int i; int quietflag, endargs, styleset, rcfile, statsflag, jsonflag, workers;
+ char *histfile, *batchfile, *servesock, *clientsock; int pipeflag; syntax_style_t mi_style=minitip_INITIAL_STYLE; 
  char mi_sepchar=minitip_INITIAL_SEPCHAR;
 
     /* some default values */
     if(HISTORY_FILE==NULL) HISTORY_FILE=strdup(DEFAULT_HISTORY_FILE);
+    if(CACHE_FILE==NULL) CACHE_FILE=strdup(DEFAULT_CACHE_FILE);
     resize_constraint_table(minitip_INITIAL_CONSTR);
     set_param("constrlimit",minitip_INITIAL_CONSTR);
     resize_macro_table(minitip_INITIAL_MACRONO);
@@ -2042,7 +3156,9 @@ int main(int argc, char *argv[])
     set_syntax_style(minitip_INITIAL_STYLE,minitip_INITIAL_SEPCHAR,1);
     set_syntax_measure(get_param("measure"),standard_measures,standard_macros);
     /* argument handling */
-    quietflag=0; endargs=0; styleset=0; rcfile=0; histfile=NULL;
+    quietflag=0; endargs=0; styleset=0; rcfile=0; histfile=NULL; statsflag=0;
+    batchfile=NULL; jsonflag=0; workers=1; servesock=NULL; clientsock=NULL;
+    pipeflag=0;
     for(i=1; i<argc && endargs==0 && argv[i][0]=='-';i++){
         switch(argv[i][1]){
       case 'h': short_help(); return EXIT_INFO;
@@ -2090,6 +3206,14 @@ int main(int argc, char *argv[])
                 }
                 RC_FILE=line; rcfile=1;
                 break;
+      case 'C': line=&(argv[i][2]);
+                if(*line==0){ i++; line=i<argc?argv[i]:NULL; }
+                if(!line || !*line){
+                   printf("Flag '-C' requires the certificate file name\n");
+                   return EXIT_ERROR;
+                }
+                cert_name=line;
+                break;
       case 'm': line=&(argv[i][2]);
                 if(*line==0){ i++; if(i<argc){ line=argv[i]; } }
                 if(!line || !*line){
@@ -2105,10 +3229,52 @@ int main(int argc, char *argv[])
                 }
                 break;
       case 'q': quietflag=1; break;
+      case 'T': statsflag=1; break;
+      case 'R': line=&(argv[i][2]);
+                if(*line==0){ i++; line=i<argc?argv[i]:NULL; }
+                if(!line || *line<'0' || *line>'9'){
+                   printf("Flag '-R' requires a number as the random seed\n");
+                   return EXIT_ERROR;
+                }
+                srandom((unsigned)strtoul(line,NULL,10));
+                break;
+      case 'b': line=&(argv[i][2]);
+                if(*line==0){ i++; line=i<argc?argv[i]:NULL; }
+                if(!line || !*line){
+                   printf("Flag '-b' requires a file name, or '-' for stdin\n");
+                   return EXIT_ERROR;
+                }
+                batchfile=line;
+                break;
+      case 'J': jsonflag=1; break;
+      case 'j': line=&(argv[i][2]);
+                if(*line==0){ i++; line=i<argc?argv[i]:NULL; }
+                if(!line || *line<'0' || *line>'9'){
+                   printf("Flag '-j' requires the number of worker processes\n");
+                   return EXIT_ERROR;
+                }
+                workers=atoi(line);
+                if(workers<=0) workers=sysconf(_SC_NPROCESSORS_ONLN);
+                if(workers<1) workers=1;
+                if(workers>minitip_MAX_WORKERS) workers=minitip_MAX_WORKERS;
+                break;
       case 'e': endargs=1; break;
+      case '-': if(strcmp(argv[i],"--pipe")==0){ pipeflag=1; break; }
+                if(strcmp(argv[i],"--serve")==0 || strcmp(argv[i],"--client")==0){
+                    i++; line=i<argc?argv[i]:NULL;
+                    if(!line || !*line){
+                        printf("Flag '%s' requires the socket name\n",argv[i-1]);
+                        return EXIT_ERROR;
+                    }
+                    if(argv[i-1][2]=='s') servesock=line; else clientsock=line;
+                    break;
+                }
+                printf("Unknown flag '%s', use '-h' for help\n",argv[i]); return EXIT_ERROR;
       default:  printf("Unknown flag '%s', use '-h' for help\n",argv[i]); return EXIT_ERROR;
         }
     }
+    if(clientsock) /* the server does the checking */
+        return client(clientsock,argc-i,argv+i,quietflag);
     /* reset default style */
     minitip_style=minitip_INITIAL_STYLE;
     minitip_sepchar=minitip_INITIAL_SEPCHAR;
@@ -2123,6 +3289,7 @@ int main(int argc, char *argv[])
        default: break;
     }
     in_minitiprc=0;
+    if(statsflag) set_param("stats",1); // command line override
     if(styleset){ // command line override
         if(constraint_no>0 && 
           (minitip_style!=mi_style || minitip_sepchar!=mi_sepchar)){
@@ -2134,14 +3301,31 @@ int main(int argc, char *argv[])
               printf(" entered in different style\n");
             }
             while(constraint_no>0){
-               constraint_no--; free(constraint_table[constraint_no]);
+               constraint_no--; free_constraint_slot(constraint_no);
             }
         }
         minitip_style=mi_style; minitip_sepchar=mi_sepchar;
         set_syntax_style(minitip_style,minitip_sepchar,get_param("simplevar"));
     }
+    if(pipeflag){ /* commands from stdin */
+        i=pipe_commands(argc-i,argv+i,jsonflag);
+        close_cache();
+        return i;
+    }
+    if(servesock){ /* answer requests on the socket */
+        i=serve(servesock,argc-i,argv+i,workers,quietflag);
+        close_cache();
+        return i;
+    }
+    if(batchfile){ /* check each line of the file */
+        i=check_bulk(batchfile,argc-i,argv+i,workers,jsonflag,quietflag);
+        close_cache();
+        return i;
+    }
     if(i<argc){ /* further arguments; do as instructed */
-        return check_offline(argc-i,argv+i,quietflag);
+        i=check_offline(argc-i,argv+i,quietflag);
+        close_cache();
+        return i;
     }
     if(quietflag || endargs) return EXIT_ERROR; /* -q flag and no argument */
     if(histfile){ // command line override
@@ -2158,6 +3342,7 @@ int main(int argc, char *argv[])
         store_if_not_new(line);
         free(line);
     }
+    close_cache();
     return 0;
 }
 
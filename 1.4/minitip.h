@@ -24,6 +24,8 @@
 #define minitip_PROMPT		"minitip: "
 /* default history file, can be override as a parameter */
 #define DEFAULT_HISTORY_FILE	".minitip"
+/* default file of the result cache, can be override as a parameter */
+#define DEFAULT_CACHE_FILE	".minitip.cache"
 /* default rc file; parse and execute before the first prompt */
 #define DEFAULT_RC_FILE		".minitiprc"
 /* initial style: syntax_short or syntax_full */
@@ -42,14 +44,26 @@
 #define minitip_MAX_ID_NO	27
 /* maximal length of a full entropy identifies */
 #define minitip_MAX_ID_LENGTH	25
-/* maximal length of a fully expanded entropy expression */
-#define minitip_MAX_EXPR_LENGTH	550
-/* maximal depth of information measure, 2^depth < MAX_EXPR_LENGTH */
+/* maximal depth of information measure */
 #define minitip_MAX_MEASURE_DEPTH 6
 /* maximal length of a line in a batch file */
 #define minitip_MAX_LINE_LENGTH	1024
 /* maximal depth of batch file embedding */
 #define minitip_MAX_BATCH_DEPTH	5
+/* maximal number of worker processes checking with flag -b */
+#define minitip_MAX_WORKERS	256
+/* maximal number of clients connected in server mode */
+#define minitip_MAX_CLIENTS	64
+
+/* default LP iteration and time limit (seconds) */
+#define minitip_ITERLIMIT	80000
+#define minitip_TIMELIMIT	10
+#define minitip_MAX_TIMELIMIT	10000
+
+/* storage class of the state of the parser and the LP modules: each
+   thread has its own, so library contexts used by different threads
+   are checked at the same time */
+#define minitip_THREAD		__thread
 
 /* return values for offline usage */
 #define EXIT_TRUE	0
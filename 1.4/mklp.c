@@ -13,6 +13,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
 #include "minitip.h"
 #include "mklp.h"
 #include "parser.h"
@@ -32,81 +38,90 @@ static inline void perm_array(int len, int *arr)
 /* random variable preparation */
 /* MAX_ID_NO should be >=26 (to handle all letters a--z),
                        <=31 (as vars a bits in an integer) */
-static int 
+static minitip_THREAD int
 /* these variables contain one bit for each variable */
   var_tr[minitip_MAX_ID_NO],	/* variable -> final value */
   var_opt[minitip_MAX_ID_NO],	/* variable optimization */
   var_all;			/* all variables */
 
-static int var_no;		/* final number of variables */
+static minitip_THREAD int var_no;	/* final number of variables */
 /** LP structure **/
-static int shannon;		/* number of Shannon inequalities */
-static int rows,cols;		/* number of rows and columns */
-static int *rowperm;		/* permutation of rows */
-static int *colperm;		/* permutation of columns */
+static minitip_THREAD int shannon;	/* number of Shannon inequalities */
+static minitip_THREAD int rows,cols;	/* number of rows and Shannon columns */
+static minitip_THREAD int *rowperm;	/* permutation of rows */
+static minitip_THREAD int *colperm;	/* permutation of constraint columns */
+/** constraint columns **/
+static minitip_THREAD struct {
+    const struct constraint_t *constr; /* which constraint */
+    int idx;			/* its index, starting from 1 */
+    int col;			/* which column of it */
+} *constr_col;			/* constraint columns */
+static minitip_THREAD int *coltag=NULL;	/* column j of P is the Shannon inequality
+				   (0) or comes from constraint k>0 */
 
 /*---------------------------------------------------------*/
-#include "glpk.h"
-static glp_prob *P=NULL;	/* glpk structure */
-static glp_smcp parm;		/* glpk parameters */
+#include "lpsolver.h"
+#include "verify.h"
+#include "symmetry.h"
+#include "simplex.h"
+#include "cache.h"
+static minitip_THREAD glp_prob *P=NULL;	/* glpk structure */
+static minitip_THREAD const struct lp_solver_t *lp_solver=NULL; /* the backend */
+static minitip_THREAD glp_smcp parm;	/* glpk parameters */
+/* rows of the goal in P. All rows are fixed at zero in the skeleton,
+   only these rows have nonzero value */
+static minitip_THREAD int *goal_row=NULL;
+static minitip_THREAD int goal_n=0;	/* number of goal rows */
+static minitip_THREAD int goal_max=0;	/* size of goal_row[] */
+static minitip_THREAD double *rowscale=NULL;	/* row scaling in consensus mode */
 
-/*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
-/* glp status and return codes */
-static char glp_msg_buffer[60];
-static char *glp_status_msg(int stat)
-{static char *statmsg[] = {
-"solution is undefined",        // GLP_UNDEF
-"solution is feasible",         // GLP_FEAS
-"solution is unfeasible",       // GLP_INFEAS
-"no feasible solution exists",  // GLP_NOFEAS
-"solution is optimal",          // GLP_OPT
-"solution is unbounded",        // GLP_UNBND
-};
-    if(1<=stat && stat<=(int)((sizeof(statmsg)/sizeof(char*))) )
-       return statmsg[stat-1];
-    sprintf(glp_msg_buffer,"unknown solution state %d", stat);
-    return glp_msg_buffer;
-}
-static char *glp_return_msg(int retval)
-{static char *retmsg[] = {
-"invalid basis",                        // GLP_EBADB     *
-"singular matrix",                      // GLP_ESING     *
-"ill-conditioned matrix",               // GLP_ECOND     *
-"invalid bounds",                       // GLP_EBOUND
-"solver failed",                        // GLP_EFAIL     *
-"objective lower limit reached",        // GLP_EOBJLL
-"objective upper limit reached",        // GLP_EOBJUL
-"iteration limit exceeded",             // GLP_EITLIM    *
-"time limit exceeded",                  // GLP_ETMLIM    *
-"no primal feasible solution",          // GLP_ENOPFS    *
-"no dual feasible solution",            // GLP_ENODFS
-"root LP optimum not provided",         // GLP_EROOT
-"search terminated by application",     // GLP_ESTOP
-"relative mip gap tolerance reached",   // GLP_EMIPGAP
-"no primal/dual feasible solution",     // GLP_ENOFEAS
-"no convergence",                       // GLP_ENOCVG
-"numerical instability",                // GLP_EINSTAB
-"invalid data",                         // GLP_EDATA
-"result out of range",                  // GLP_ERANGE
-};
-    if(1<=retval && retval <= (int)((sizeof(retmsg)/sizeof(char*))))
-        return retmsg[retval-1];
-    sprintf(glp_msg_buffer,"unknown lp code %d", retval);
-    return glp_msg_buffer;
+/*---------------------------------------------------------*/
+/* statistics */
+minitip_THREAD struct lp_stats_t lp_stats;
+static minitip_THREAD double stats_wall0[STAT_PHASES], stats_cpu0[STAT_PHASES];
+
+static double clock_seconds(clockid_t clk)
+{struct timespec ts;
+    clock_gettime(clk,&ts);
+    return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+void lp_stats_reset(void)
+{   memset(&lp_stats,0,sizeof(lp_stats)); }
+void lp_stats_start(int phase)
+{   stats_wall0[phase]=clock_seconds(CLOCK_MONOTONIC);
+    stats_cpu0[phase]=clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+void lp_stats_stop(int phase)
+{   lp_stats.wall[phase]+=clock_seconds(CLOCK_MONOTONIC)-stats_wall0[phase];
+    lp_stats.cpu[phase]+=clock_seconds(CLOCK_PROCESS_CPUTIME_ID)-stats_cpu0[phase];
 }
 
-/** create the initial glp problem, define the rows and columns **/
-static void create_glp(void)
-{int i;
+/** Shannon skeleton cache
+   The columns of the Shannon inequalities depend only on the number
+   of final variables. For each var_no the LP containing these columns
+   is created once and kept; a check copies it and adds the constraint
+   columns and the goal only. The row permutation is part of the
+   skeleton; it is dropped when the LP solver fails, so that the next
+   check starts with a fresh permutation. **/
+static minitip_THREAD struct skeleton_t {
+    glp_prob *P;		/* rows and Shannon columns */
+    int *rowperm;		/* row permutation used */
+} skeleton[minitip_MAX_ID_NO+1];
+
+/** create the glp problem: copy the skeleton and add the columns
+    for the constraints. The skeleton must exist. **/
+static void create_glp(int constraints)
+{   lp_solver->reset();
     P=glp_create_prob();
-    glp_add_cols(P,cols); glp_add_rows(P,rows);
-    /* set the objective to all zero */
-    for(i=0;i<=cols;i++)glp_set_obj_coef(P,i,0.0);
+    glp_copy_prob(P,skeleton[var_no].P,GLP_OFF);
+    goal_n=0; /* all rows are zero */
+    if(constraints>0) glp_add_cols(P,constraints);
     glp_set_obj_dir(P,GLP_MIN); /* minimize */
 }
 /* clean up all results */
 static void release_glp(void){
     if(P){ glp_delete_prob(P); P=NULL; }
+    if(lp_solver) lp_solver->reset();
 }
 /* init glp parameters. These should be changeable some way */
 static void init_glp_parameters(int iterlimit, int timelimit){
@@ -126,40 +141,51 @@ static void init_glp_parameters(int iterlimit, int timelimit){
 
 /*- - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 /* add a column to */
-/** arrays to pass a column to glpk */
-static int    row_idx[minitip_MAX_EXPR_LENGTH+1];
-static double row_val[minitip_MAX_EXPR_LENGTH+1];
-
-/* sort by idx; indices go 1<=i<=n */
-static void sort_rowidx(int n) /* bubble sort */
-{int OK;int i,t; double vt;
-    OK=0; while(!OK){
-        OK=1;
-        for(i=1;i<n;i++) if(row_idx[i]>row_idx[i+1]){
-           OK=0;
-           t=row_idx[i];row_idx[i]=row_idx[i+1]; row_idx[i+1]=t;
-           vt=row_val[i];row_val[i]=row_val[i+1];row_val[i+1]=vt;
-        }
+/** arrays to pass a column to glpk, grown by row_room() */
+static minitip_THREAD int    *row_idx=NULL;
+static minitip_THREAD double *row_val=NULL;
+static minitip_THREAD int    row_max=0;
+
+/* make room for n entries in row_idx,row_val[1..n] and goal_row[1..n].
+   Returns 0 if out of memory. */
+static int row_room(int n)
+{int *idx; double *val;
+    n++; if(n<16) n=16;
+    if(n>row_max){
+        if((idx=realloc(row_idx,n*sizeof(int)))==NULL) return 0;
+        row_idx=idx;
+        if((val=realloc(row_val,n*sizeof(double)))==NULL) return 0;
+        row_val=val; row_max=n;
     }
+    if(n>goal_max){
+        if((idx=realloc(goal_row,n*sizeof(int)))==NULL) return 0;
+        goal_row=idx; goal_max=n;
+    }
+    return 1;
 }
-/* add the next column. 
+
+/* add the next column. glpk does not need sorted indices, only
+   distinct ones.
    col  = index of the column (1<=col<=cols)
    n    = number of entries in row_idx[],row_val[] (1<=i<=n)
    type = GLP_FR: free; GLP_LO: >=0 */
 static void add_column(int col,int n,int type)
-{   sort_rowidx(n);
+{   lp_solver->reset(); // the matrix changes
     glp_set_col_bnds(P,col,type,0.0,0.0);
     glp_set_mat_col(P,col,n,row_idx,row_val);
 }
-/* add the goal, it is in row_idx,row_val[1..n] */
+/* add the goal, it is in row_idx,row_val[1..n]. Only the rows of
+   the previous and the new goal are touched. */
 static void add_goal(int n)
-{int i,in; double v;
-    sort_rowidx(n);
-    for(i=1,in=1;i<=rows;i++){
-        if(in<=n && row_idx[in]==i){ v=row_val[in]; in++; }
-        else { v=0.0; }
-        glp_set_row_bnds(P,i,GLP_FX,v,0.0);
+{int i;
+    for(i=1;i<=goal_n;i++)
+        glp_set_row_bnds(P,goal_row[i],GLP_FX,0.0,0.0);
+    for(i=1;i<=n;i++){
+        glp_set_row_bnds(P,row_idx[i],GLP_FX,
+           rowscale ? rowscale[row_idx[i]]*row_val[i] : row_val[i],0.0);
+        goal_row[i]=row_idx[i];
     }
+    goal_n=n;
 }
 
 /*---------------------------------------------------------*/
@@ -216,27 +242,29 @@ static int do_variable_assignment(void)
     cols = shannon+var_no; /* plus the N-{i}<=N inequalities */
     return 0;
 }
-/* get the translated variable */
-static int varidx(int v)
+/* get the translated variable as a subset of the final variables,
+   and the corresponding row */
+static int varmask(int v)
 {int i,w;
     for(w=0,i=0;v;i++,v>>=1)if(v&1){ w|=var_tr[i]; }
-    return rowperm[w];
+    return w;
 }
+static int varidx(int v)
+{   return rowperm[varmask(v)]; }
 
-/* create the idx-th Shannon inequality
-    the last var_no-2 bits give a subset, before it is the two extra vars
-    don't do variable translation, use only the rowperm[] table
+/* create the idx-th Shannon inequality in idx[],val[], return the
+    number of entries. The last var_no-2 bits give a subset, before it
+    is the two extra vars. Rows are the subsets in increasing order,
+    the caller translates them by the rowperm[] table.
 */
-static int add_shannon(int i,int idx)
+static int shannon_column(int idx, int *row, double *val)
 {int v1,v2,v3; int mask;
-    if(idx>=shannon+var_no) return 1;
     if(idx>=shannon){         // abcdef - abcd
         v1=(1<<var_no)-1;     // all variables
         v2= 1<<(idx-shannon); // single variables
-        row_idx[1]=rowperm[v1];     row_val[1]=1.0;
-        row_idx[2]=rowperm[v1&~v2]; row_val[2]=-1.0;
-        add_column(i,var_no<2?1:2,GLP_LO);
-        return 0;
+        row[0]=v1&~v2;  val[0]=-1.0;
+        row[1]=v1;      val[1]=1.0;
+        return 2;
     }
     xassert(var_no>=2);
     v2=idx>>(var_no-2); // determine v1 and v2
@@ -247,137 +275,1160 @@ static int add_shannon(int i,int idx)
     // make zero at places v1 and v2 shifting the rest of v3
     mask = -1+v2; v3= (v3&mask) | ((v3&~mask)<<1);
     mask = -1+v1; v3= (v3&mask) | ((v3&~mask)<<1);
-    row_idx[1]=rowperm[v1|v3];     row_val[1]=+1.0;
-    row_idx[2]=rowperm[v2|v3];     row_val[2]=+1.0;
-    row_idx[3]=rowperm[v1|v2|v3];  row_val[3]=-1.0;
-    row_idx[4]=rowperm[v3];        row_val[4]=-1.0;
-    add_column(i, v3==0?3:4, GLP_LO);
-    return 0;
+    if(v3==0){
+        row[0]=v2;        val[0]=+1.0;
+        row[1]=v1;        val[1]=+1.0;
+        row[2]=v1|v2;     val[2]=-1.0;
+        return 3;
+    }
+    row[0]=v3;        val[0]=-1.0;
+    row[1]=v2|v3;     val[1]=+1.0;
+    row[2]=v1|v3;     val[2]=+1.0;
+    row[3]=v1|v2|v3;  val[3]=-1.0;
+    return 4;
 }
 
-static void add_constraint(int col,int idx,int next_expr(int))
-{int i,nextexpr;
-    for(i=0;idx>=0;i++){
-        nextexpr=next_expr(i);
-        xassert(nextexpr==0);
-        if(entropy_expr.type == ent_Markov){
-            if(idx>entropy_expr.n-3){ idx -= entropy_expr.n-2; continue; }
-            int v1,v2,v; int j;
-            // add idx-th Markov equality
-            v=v1=v2=0; for(j=0;j<entropy_expr.n;j++){
-                if(j<idx+1) v1 |= entropy_expr.item[j].var;
-                else if(j>idx+1) v2 |= entropy_expr.item[j].var;
-                else v=entropy_expr.item[j].var;
-            } // (v1,v2|v)=0
-            row_idx[1]=varidx(v1|v);    row_val[1]=1.0;
-            row_idx[2]=varidx(v2|v);    row_val[2]=1.0;
-            row_idx[3]=varidx(v1|v2|v); row_val[3]=-1.0;
-            row_idx[4]=varidx(v);       row_val[4]=-1.0;
-            add_column(col,4,GLP_FR);
-            return;
-        } else if(idx>0) { idx--; continue; }
-        else { // add this constraint
-            int j;
-            for(j=0;j<entropy_expr.n;j++){
-                row_idx[j+1]=varidx(entropy_expr.item[j].var);
-                row_val[j+1]=entropy_expr.item[j].coeff;
-            }
-            add_column(col,entropy_expr.n, entropy_expr.type==ent_eq?GLP_FR : GLP_LO);
-            return;
-        }
+/* add the idx-th constraint column as the col-th column */
+static void add_constraint(int col,int idx)
+{int i,j; const struct constraint_t *c=constr_col[idx].constr;
+    i=constr_col[idx].col;
+    for(j=c->col[i].from;j<c->col[i].to;j++){
+        row_idx[j-c->col[i].from+1]=varidx(c->item[j].gvar);
+        row_val[j-c->col[i].from+1]=c->item[j].coeff;
     }
-    xassert(idx!=idx);
+    add_column(col,c->col[i].to-c->col[i].from,
+               c->col[i].type==ent_eq ? GLP_FR : GLP_LO);
 }
 
-/* call the LP solver; mult is either +1.0 or -1.0 */
+/* call the LP solver backend, record the LP size and the work done */
 static char *invoke_lp(void)
-{int glp_res;
-    glp_res=glp_simplex(P,&parm);
-    switch(glp_res){
-  case 0:           glp_res=glp_get_status(P); break;
-  case GLP_ENOPFS:  // no primal feasible solution
-                    glp_res=GLP_NOFEAS; break;
-  default:          return glp_return_msg(glp_res);
-    }
-    return (glp_res==GLP_OPT ? EXPR_TRUE :
-            glp_res==GLP_NOFEAS ? EXPR_FALSE :
-            glp_status_msg(glp_res));
-}
-
-char *call_lp(int next_expr(int), int iterlimit, int timelimit)
-{int i,constraints; expr_type_t goal_type; 
- char *retval, *retval2;
-    /* initially the expression to be checked is in entropy_expr.
-       determine first the variables */
-    init_var_assignment(); /* start collecting variables */
-    add_expr_variables();  /* variables in the expression to be checked */
-    constraints=0;
-    for(i=0;next_expr(i)==0;i++){ /* go over all constraints */
-        constraints++;
-         // Markov constraints give n-3 cols
-        if(entropy_expr.type==ent_Markov){
-            constraints+=entropy_expr.n-3;
-        }
-        add_expr_variables();
+{char *retval; size_t peak;
+    lp_stats.rows=glp_get_num_rows(P); lp_stats.cols=glp_get_num_cols(P);
+    lp_stats.nonzeros=glp_get_num_nz(P);
+    lp_stats_start(STAT_SOLVE);
+    retval=lp_solver->solve(P,&parm);
+    lp_stats_stop(STAT_SOLVE);
+    lp_stats.iterations+=lp_solver->iterations(P);
+    glp_mem_usage(NULL,NULL,NULL,&peak);
+    if(peak>lp_stats.mem_peak) lp_stats.mem_peak=peak;
+    return retval;
+}
+
+/* release allocated memory */
+static void release_tables(void)
+{   if(colperm){ free(colperm); colperm=NULL; }
+    if(constr_col){ free(constr_col); constr_col=NULL; }
+}
+
+/*---------------------------------------------------------*/
+/* make sure that the skeleton for var_no exists; set rowperm.
+   The matrix is generated in one pass into the ia/ja/ar arrays and
+   passed to glpk by a single glp_load_matrix() call. Room is made
+   in row_idx[] and row_val[] for a column or goal of all rows.
+   Returns 1 if out of memory. */
+static int make_skeleton(void)
+{int i,nz,*perm,*cperm,*ia,*ja; double *ar;
+    if(!row_room(rows)) return 1;
+    if(skeleton[var_no].P){ rowperm=skeleton[var_no].rowperm; return 0; }
+    /* each Shannon column has at most 4, the last var_no have 2 entries */
+    nz=4*shannon+2*var_no;
+    perm=malloc((rows+1)*sizeof(int));
+    cperm=malloc((cols+1)*sizeof(int));
+    ia=malloc((nz+1)*sizeof(int));
+    ja=malloc((nz+1)*sizeof(int));
+    ar=malloc((nz+1)*sizeof(double));
+    if(!perm || !cperm || !ia || !ja || !ar){
+        if(perm) free(perm);
+        if(cperm) free(cperm);
+        if(ia) free(ia);
+        if(ja) free(ja);
+        if(ar) free(ar);
+        return 1;
     }
-    /* figure out final variables, rows, cols, number of Shannon */
-    if(do_variable_assignment()){ // number of variables is less than 2
-        return "number of final random variables is less than 2";
+    for(i=0;i<=rows;i++){perm[i]=i;}    perm_array(rows+1,perm);
+    for(i=0;i<=cols;i++){cperm[i]=i-1;} perm_array(cols+1,cperm);
+    rowperm=perm;
+    for(i=1,nz=0;i<=cols;i++){int k,n;
+        n=shannon_column(cperm[i],ia+nz+1,ar+nz+1);
+        for(k=1;k<=n;k++){ ia[nz+k]=perm[ia[nz+k]]; ja[nz+k]=i; }
+        nz+=n;
     }
-    /* get memory for row and column permutation */
-    cols += constraints;
-    rowperm=malloc((rows+1)*sizeof(int));
-    colperm=malloc((cols+1)*sizeof(int));
-    if(!rowperm || !colperm){
-        if(rowperm){ free(rowperm); rowperm=NULL; }
-        if(colperm){ free(colperm); colperm=NULL; }
+    P=glp_create_prob();
+    glp_add_cols(P,cols); glp_add_rows(P,rows);
+    glp_load_matrix(P,nz,ia,ja,ar);
+    free(ia); free(ja); free(ar); free(cperm);
+    /* set the objective to all zero */
+    for(i=0;i<=cols;i++)glp_set_obj_coef(P,i,0.0);
+    glp_set_obj_dir(P,GLP_MIN); /* minimize */
+    for(i=1;i<=cols;i++) glp_set_col_bnds(P,i,GLP_LO,0.0,0.0);
+    for(i=1;i<=rows;i++) glp_set_row_bnds(P,i,GLP_FX,0.0,0.0);
+    skeleton[var_no].P=P; skeleton[var_no].rowperm=perm; P=NULL;
+    return 0;
+}
+/* forget the skeleton for var_no */
+static void drop_skeleton(void)
+{   if(skeleton[var_no].P){
+        glp_delete_prob(skeleton[var_no].P);
+        free(skeleton[var_no].rowperm);
+        skeleton[var_no].P=NULL; skeleton[var_no].rowperm=NULL;
+    }
+}
+
+/*---------------------------------------------------------*/
+/* Session LP
+   Consecutive checks typically differ in the goal only. The LP with
+   its last basis is kept together with the constraint list and the
+   variable assignment it was built for. When they match, the goal
+   bounds are replaced and the dual simplex is restarted from the
+   previous basis without presolve. As the objective is zero, every
+   basis is dual feasible. */
+static minitip_THREAD struct session_t {
+    int valid;			/* P is the session LP */
+    int var_no;			/* number of final variables */
+    int var_tr[minitip_MAX_ID_NO]; /* variable assignment */
+    int constrno;		/* number of constraints */
+    const struct constraint_t **constr; /* the constraints */
+} session;
+
+void invalidate_lp(void)
+{   release_glp();
+    if(coltag){ free(coltag); coltag=NULL; }
+    session.valid=0;
+    if(session.constr){ free(session.constr); session.constr=NULL; }
+}
+/*---------------------------------------------------------*/
+/* LP state
+   The skeletons, the session LP with the goal rows, the backend, and
+   the results of the last check are kept between checks;
+   lp_state_swap() exchanges them with a saved state. The backend
+   forgets its copy of P first, as that copy belongs to the state being
+   swapped out. */
+struct lp_state_t {
+    struct skeleton_t skeleton[minitip_MAX_ID_NO+1];
+    struct session_t session;
+    glp_prob *P;
+    int *coltag;
+    int *goal_row;
+    int goal_n, goal_max;
+    const struct lp_solver_t *lp_solver;
+    struct lp_stats_t stats;
+    struct lp_consensus_t consensus;
+    int verified, formulation;
+};
+
+static void swap_mem(void *a, void *b, size_t n)
+{unsigned char *p=a,*q=b,t;
+    while(n--){ t=*p; *p++=*q; *q++=t; }
+}
+#define swap_var(x,y)	swap_mem(&(x),&(y),sizeof(x))
+
+struct lp_state_t *lp_state_new(void)
+{   return calloc(1,sizeof(struct lp_state_t)); }
+
+void lp_state_swap(struct lp_state_t *s)
+{   if(lp_solver) lp_solver->reset();
+    swap_var(skeleton,s->skeleton); swap_var(session,s->session);
+    swap_var(P,s->P); swap_var(coltag,s->coltag);
+    swap_var(goal_row,s->goal_row); swap_var(goal_n,s->goal_n);
+    swap_var(goal_max,s->goal_max);
+    swap_var(lp_solver,s->lp_solver);
+    swap_var(lp_stats,s->stats); swap_var(lp_consensus,s->consensus);
+    swap_var(lp_verified,s->verified);
+    swap_var(lp_formulation,s->formulation);
+}
+
+const struct lp_stats_t *lp_state_stats(const struct lp_state_t *s)
+{   return &s->stats; }
+
+void lp_release_buffers(void)
+{   if(row_idx) free(row_idx);
+    if(row_val) free(row_val);
+    if(goal_row) free(goal_row);
+    row_idx=NULL; row_val=NULL; row_max=0;
+    goal_row=NULL; goal_n=0; goal_max=0;
+    glp_free_env();
+}
+
+void lp_state_free(struct lp_state_t *s)
+{int i;
+    if(!s) return;
+    lp_state_swap(s);
+    invalidate_lp();
+    for(i=0;i<=minitip_MAX_ID_NO;i++) if(skeleton[i].P){
+        glp_delete_prob(skeleton[i].P); free(skeleton[i].rowperm);
+        skeleton[i].P=NULL; skeleton[i].rowperm=NULL;
+    }
+    lp_state_swap(s);
+    if(s->goal_row) free(s->goal_row);
+    free(s);
+}
+
+/* check whether the session LP can be used */
+static int session_match(int constrno, struct constraint_t *const constr[])
+{int i;
+    if(!session.valid || !P || session.var_no!=var_no ||
+       session.constrno!=constrno) return 0;
+    for(i=0;i<minitip_MAX_ID_NO;i++)
+        if(session.var_tr[i]!=var_tr[i]) return 0;
+    for(i=0;i<constrno;i++) if(session.constr[i]!=constr[i]) return 0;
+    return 1;
+}
+/* remember the key of the LP in P; if no memory, don't keep it */
+static void session_save(int constrno, struct constraint_t *const constr[])
+{int i;
+    session.constr=malloc((constrno+1)*sizeof(*session.constr));
+    if(!session.constr) return;
+    for(i=0;i<constrno;i++) session.constr[i]=constr[i];
+    for(i=0;i<minitip_MAX_ID_NO;i++) session.var_tr[i]=var_tr[i];
+    session.var_no=var_no; session.constrno=constrno;
+    session.valid=1;
+}
+
+/* create a new LP in P for the constraints. Variable assignment has
+   been done. Returns NULL or an error message */
+static char *build_lp(int constrno, struct constraint_t *const constr[])
+{int i,j,k,constraints;
+    lp_stats_start(STAT_BUILD);
+    for(i=0,constraints=0;i<constrno;i++) constraints += constr[i]->cols;
+    /* get the skeleton, memory for constraint permutation */
+    if(coltag) free(coltag);
+    colperm=malloc((constraints+1)*sizeof(int));
+    constr_col=malloc((constraints+1)*sizeof(*constr_col));
+    coltag=malloc((cols+constraints+1)*sizeof(int));
+    if(!colperm || !constr_col || !coltag || make_skeleton()){
+        release_tables();
+        if(coltag){ free(coltag); coltag=NULL; }
+        lp_stats_stop(STAT_BUILD);
         return "the problem is too large, not enough memory";
     }
-    for(i=0;i<=rows;i++){rowperm[i]=i;}   perm_array(rows+1,rowperm);
-    for(i=0;i<=cols;i++){colperm[i]=i-1;} perm_array(cols+1,colperm);
-    /* the expression to be checked, this will be the goal */
-    if(constraints) next_expr(-1);
-    goal_type=entropy_expr.type; // ent_eq, ent_ge
-    create_glp(); // create a new glp instance
-    for(i=0;i<entropy_expr.n;i++){
-        row_idx[i+1]=varidx(entropy_expr.item[i].var);
-        row_val[i+1]=entropy_expr.item[i].coeff;
-    }
-    add_goal(entropy_expr.n); // right hand side value
-    // go over the columns add them to the lp instance
-    for(i=1;i<=cols;i++){
-        int colct=colperm[i];
-        if(add_shannon(i,colct)){ // this is a constraint
-            add_constraint(i,colct-(shannon+var_no),next_expr);
+    for(i=0;i<=constraints;i++){colperm[i]=i-1;} perm_array(constraints+1,colperm);
+    for(i=0,k=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++,k++){
+        constr_col[k].constr=constr[i]; constr_col[k].idx=i+1;
+        constr_col[k].col=j;
+    }
+    create_glp(constraints); // copy the skeleton
+    for(i=0;i<=cols;i++) coltag[i]=0;
+    // constraint columns go after the Shannon ones in random order
+    for(i=1;i<=constraints;i++){
+        add_constraint(shannon+var_no+i,colperm[i]);
+        coltag[cols+i]=constr_col[colperm[i]].idx;
+    }
+    release_tables();
+    lp_stats_stop(STAT_BUILD);
+    return NULL;
+}
+
+/* the column values of the last solution in P, from glp_exact() if
+   exact is set. NULL if out of memory */
+static double *column_values(int exact)
+{int j,n; double *x;
+    n=glp_get_num_cols(P);
+    x=malloc((n+1)*sizeof(double));
+    if(x) for(j=1;j<=n;j++)
+        x[j] = exact ? glp_get_col_prim(P,j) : lp_solver->col_prim(P,j);
+    return x;
+}
+
+/* check the verdict of the LP solver in exact arithmetic. If rounding the
+   solution does not give a proof, call the exact simplex method and
+   use its verdict. When cert is not NULL, write the certificate. */
+minitip_THREAD int lp_verified;
+static char *verify_lp(char *retval, FILE *certfile)
+{int level,i,ok,*rowset; char *exact; struct cert_t cert,*cp; double *x;
+    if(retval!=EXPR_TRUE && retval!=EXPR_FALSE) return retval;
+    lp_stats_start(STAT_VERIFY);
+    rowset=NULL; cp=NULL; x=NULL;
+    if(certfile && (rowset=malloc((rows+1)*sizeof(int)))){
+        for(i=1;i<=rows;i++) rowset[rowperm[i]]=i;
+        cert.f=certfile; cert.rowset=rowset; cert.coltag=coltag;
+        cp=&cert; cert_goal(P,cp);
+    }
+    if(retval==EXPR_TRUE ? verify_feasible(P,(x=column_values(0)),cp) :
+                           verify_infeasible(P,&parm,cp)){
+        level=VERIFY_CERT; ok=1;
+    } else {
+        exact=NULL; ok=0;
+        if(glp_exact(P,&parm)==0){
+            if(glp_get_status(P)==GLP_OPT) exact=EXPR_TRUE;
+            else if(glp_get_status(P)==GLP_NOFEAS) exact=EXPR_FALSE;
         }
+        if(exact==NULL) level=VERIFY_FAILED;
+        else if(exact==retval) level=VERIFY_EXACT;
+        else { level=VERIFY_FIXED; retval=exact; }
+        if(exact==EXPR_TRUE && cp){ // the exact solution may be rounded
+            if(x) free(x);
+            ok=verify_feasible(P,(x=column_values(1)),cp);
+        }
+    }
+    if(x) free(x);
+    if(cp){
+        if(!ok) fprintf(certfile,"%s none\n",retval==EXPR_TRUE ? "TRUE" : "FALSE");
+        fprintf(certfile,"end\n");
+        free(rowset);
+    }
+    if(level>lp_verified) lp_verified=level;
+    lp_stats_stop(STAT_VERIFY);
+    return retval;
+}
+
+/* write the certificate header: the final variables */
+static void cert_header(FILE *f)
+{int i,k; const char *name;
+    fprintf(f,"minitip certificate\n");
+    for(k=0;k<var_no;k++){
+        fprintf(f,"var %d",1<<k);
+        for(i=0;i<minitip_MAX_ID_NO;i++) if(var_tr[i]==(1<<k)){
+            name=get_idname(i); fprintf(f," %s",name ? name : "?");
+        }
+        fprintf(f,"\n");
     }
+}
+
+/* put the goal multiplied by sign into row_idx,row_val[1..n] and
+   return n. Terms falling into the same row are added up; this
+   happens in the symmetry reduced LP only. pos[r] is the place of
+   row r, if no memory, rows are searched for. */
+static int goal_rows(double sign)
+{int i,j,n,r; int *pos;
+    pos=calloc(rows+1,sizeof(int));
+    for(i=0,n=0;i<entropy_expr.n;i++){
+        r=varidx(entropy_expr.item[i].var);
+        if(pos) j= pos[r] ? pos[r] : n+1;
+        else for(j=1;j<=n && row_idx[j]!=r;j++);
+        if(j>n){ n++; row_idx[n]=r; row_val[n]=0.0; if(pos) pos[r]=n; }
+        row_val[j] += sign*entropy_expr.item[i].coeff;
+    }
+    if(pos) free(pos);
+    return n;
+}
+
+/* combine the verdicts for >= and <= when checking = */
+static char *eq_verdict(char *retval, char *retval2)
+{   if(retval2==EXPR_TRUE){
+        if(retval==EXPR_FALSE) retval=EQ_LE_ONLY;
+    } else if(retval2==EXPR_FALSE){
+        if(retval==EXPR_TRUE) retval=EQ_GE_ONLY;
+    } else {
+        retval=retval2;
+    }
+    return retval;
+}
+
+/* solve the LP in P with goal in entropy_expr; warm: start from the
+   previous basis; variant: solver configuration, see below */
+static void set_variant(int variant);
+static char *solve_goal(int warm, const struct lp_options_t *opt, int variant)
+{char *retval, *retval2;
+    add_goal(goal_rows(1.0)); // right hand side value
     /* call the lp */
-    init_glp_parameters(iterlimit,timelimit);
-    if(parm.presolve!=GLP_ON) // generate the first basis
+    init_glp_parameters(opt->iterlimit,opt->timelimit);
+    set_variant(variant);
+    if(warm) parm.presolve=GLP_OFF;
+    else if(parm.presolve!=GLP_ON) // generate the first basis
         glp_adv_basis(P,0);
 
     retval=invoke_lp();
+    if(opt->verify || opt->cert) retval=verify_lp(retval,opt->cert);
     // call again with -1.0 when checking for ent_eq
-    if(goal_type==ent_eq && (retval==EXPR_TRUE || retval==EXPR_FALSE)){
-        next_expr(-1); // reload the problem
-        for(i=0;i<entropy_expr.n;i++){
-            row_idx[i+1]=varidx(entropy_expr.item[i].var);
-            row_val[i+1]=-entropy_expr.item[i].coeff;
-        }
-        add_goal(entropy_expr.n); // right hand side value
+    if(entropy_expr.type==ent_eq && (retval==EXPR_TRUE || retval==EXPR_FALSE)){
+        add_goal(goal_rows(-1.0)); // right hand side value
         retval2=invoke_lp();
-        if(retval2==EXPR_TRUE){
-            if(retval==EXPR_FALSE) retval=EQ_LE_ONLY;
-        } else if(retval2==EXPR_FALSE){
-            if(retval==EXPR_TRUE) retval=EQ_GE_ONLY;
-        } else {
-            retval=retval2;
+        if(opt->verify || opt->cert) retval2=verify_lp(retval2,opt->cert);
+        retval=eq_verdict(retval,retval2);
+    }
+    return retval;
+}
+
+#define decided(r)	\
+    ((r)==EXPR_TRUE || (r)==EXPR_FALSE || (r)==EQ_GE_ONLY || (r)==EQ_LE_ONLY)
+
+/*---------------------------------------------------------*/
+/* Parallel solvers
+   Several copies of the LP are solved in parallel. glpk cannot
+   interrupt a running simplex from another thread, so the solvers are
+   forked processes which are killed when no longer needed. A child
+   inherits the LP in P, modifies and solves it, and sends the result
+   through a pipe.
+
+   Portfolio: differently configured solvers race, the first definite
+   answer is taken. Variants:
+     0   the default: dual simplex, projected steepest edge
+     1   primal simplex
+     2   dual simplex with textbook pricing and ratio test
+    3-   new row and column permutation, alternating dual and primal
+   Consensus: solver 0 uses the LP as is, the others a new permutation
+   with rows and columns scaled by random powers of two. All answers
+   are collected and the majority verdict is returned.
+*/
+static void set_variant(int variant)
+{   if(variant<=0) return;
+    if(variant==2){
+        parm.pricing=GLP_PT_STD; parm.r_test=GLP_RT_STD;
+    } else if(variant&1){
+        parm.meth=GLP_PRIMAL;
+    }
+}
+
+/* scale rows and columns of P by random powers of two between 1/8 and
+   8. Powers of two keep the coefficients exact; the solver path
+   changes only. rowscale[] is used by add_goal() */
+static void scale_lp(void)
+{int i,j,k,n,*ind; double *val,sj;
+    rowscale=malloc((rows+1)*sizeof(double));
+    ind=malloc((rows+1)*sizeof(int));
+    val=malloc((rows+1)*sizeof(double));
+    if(!rowscale || !ind || !val) _exit(1); /* the parent sees an error */
+    lp_solver->reset();
+    for(i=1;i<=rows;i++) rowscale[i]=(double)(1<<mrandom(7))/8.0;
+    for(j=glp_get_num_cols(P);j>0;j--){
+        sj=(double)(1<<mrandom(7))/8.0;
+        n=glp_get_mat_col(P,j,ind,val);
+        for(k=1;k<=n;k++) val[k] *= sj*rowscale[ind[k]];
+        glp_set_mat_col(P,j,n,ind,val);
+    }
+    free(ind); free(val);
+}
+
+/* the result as sent through the pipe */
+struct lp_result_t {
+    int code;			/* 1..4: decided; 0: error in msg */
+    int verified;		/* lp_verified of the child */
+    char msg[80];		/* error message */
+};
+static char *decided_code[]={NULL,EXPR_TRUE,EXPR_FALSE,EQ_GE_ONLY,EQ_LE_ONLY};
+static minitip_THREAD char solver_msg[80];	/* returned error message */
+
+minitip_THREAD struct lp_consensus_t lp_consensus;
+
+/* the child: set up the LP, solve and report. The seed is drawn by
+   the parent, thus runs seeded by -R are repeatable */
+static void solver_child(int fd, int warm, int constrno,
+       struct constraint_t *const constr[], const struct lp_options_t *opt,
+       int idx, int consensus, unsigned seed)
+{struct lp_result_t res; char *retval; int i;
+    srandom(seed);
+    lp_solver->reset(); // don't share the backend with the parent
+    retval=NULL;
+    if(idx>=(consensus ? 1 : 3)){ // forget the skeleton, new permutation
+        skeleton[var_no].P=NULL; skeleton[var_no].rowperm=NULL;
+        P=NULL; warm=0;
+        retval=build_lp(constrno,constr);
+        if(!retval && consensus) scale_lp();
+    }
+    if(!retval) retval=solve_goal(warm,opt,consensus ? 0 : idx);
+    memset(&res,0,sizeof(res));
+    res.verified=lp_verified;
+    for(i=1;i<5;i++) if(retval==decided_code[i]) res.code=i;
+    if(res.code==0) strncpy(res.msg,retval,sizeof(res.msg)-1);
+    if(write(fd,&res,sizeof(res))!=sizeof(res)){ /* ignore */ }
+    _exit(0);
+}
+
+/* run n solvers. When consensus is not set, stop at the first definite
+   answer and store it in result[0]; otherwise wait for all and store
+   their answers in result[0..n-1]. An error message is stored as
+   solver_msg. verified[] gets the verification level. Returns the
+   number of solvers which reported, or -1 if no child can be created. */
+static int run_solvers(int n, int consensus, int warm, int constrno,
+       struct constraint_t *const constr[], const struct lp_options_t *opt,
+       char *result[], int verified[])
+{int i,j,running,reported,fd[2]; pid_t *pid; struct pollfd *pfd;
+ struct lp_result_t res; unsigned seed;
+    pid=malloc(n*sizeof(pid_t)); pfd=malloc(n*sizeof(struct pollfd));
+    if(!pid || !pfd){
+        if(pid) free(pid);
+        if(pfd) free(pfd);
+        return -1;
+    }
+    fflush(stdout); fflush(stderr);
+    strcpy(solver_msg,"LP solver aborted");
+    for(i=0,running=0;i<n;i++){
+        pid[i]=-1; pfd[i].fd=-1; pfd[i].events=POLLIN;
+        result[i]=NULL; if(consensus) verified[i]=VERIFY_NONE;
+        if(pipe(fd)) continue;
+        seed=(unsigned)random();
+        pid[i]=fork();
+        if(pid[i]==0){ // child
+            close(fd[0]);
+            for(j=0;j<i;j++) if(pfd[j].fd>=0) close(pfd[j].fd);
+            solver_child(fd[1],warm,constrno,constr,opt,i,consensus,seed);
+        }
+        close(fd[1]);
+        if(pid[i]<0){ close(fd[0]); continue; }
+        pfd[i].fd=fd[0]; running++;
+    }
+    reported=0;
+    while(running>0 && (consensus || !decided(result[0]))){
+        if(poll(pfd,n,-1)<0) break;
+        for(i=0;i<n;i++){
+            if(pfd[i].fd<0 || pfd[i].revents==0) continue;
+            if(read(pfd[i].fd,&res,sizeof(res))!=sizeof(res)){
+                res.code=0; strcpy(res.msg,"LP solver aborted");
+            }
+            close(pfd[i].fd); pfd[i].fd=-1; running--; reported++;
+            j = consensus ? i : 0;
+            if(res.code>0){
+                result[j]=decided_code[res.code]; verified[j]=res.verified;
+                if(!consensus) break;
+            } else if(consensus || result[0]==NULL || i==0){
+                res.msg[sizeof(res.msg)-1]=0;
+                strcpy(solver_msg,res.msg); result[j]=solver_msg;
+            }
+        }
+    }
+    for(i=0;i<n;i++){
+        if(pid[i]<=0) continue;
+        if(pfd[i].fd>=0){ kill(pid[i],SIGKILL); close(pfd[i].fd); }
+        waitpid(pid[i],NULL,0);
+    }
+    for(i=0,j=0;i<n;i++) if(pid[i]>0) j++; // number of solvers started
+    free(pid); free(pfd);
+    return j==0 ? -1 : reported;
+}
+
+/* portfolio: first definite answer or an error; NULL if no solver
+   could be started */
+static char *run_portfolio(int warm, int constrno,
+       struct constraint_t *const constr[], const struct lp_options_t *opt)
+{char *result[1]; int verified[1]={VERIFY_NONE};
+    if(run_solvers(opt->portfolio,0,warm,constrno,constr,opt,result,verified)<0)
+        return NULL;
+    if(decided(result[0])) lp_verified=verified[0];
+    return result[0];
+}
+
+/* consensus: the majority verdict; fill lp_consensus. NULL if no solver
+   could be started */
+static char *run_consensus(int warm, int constrno,
+       struct constraint_t *const constr[], const struct lp_options_t *opt)
+{char **result; int *verified,cnt[5],i,k,best,n;
+    n=opt->consensus;
+    result=malloc(n*sizeof(char*)); verified=malloc(n*sizeof(int));
+    if(!result || !verified){
+        if(result) free(result);
+        if(verified) free(verified);
+        return NULL;
+    }
+    if(run_solvers(n,1,warm,constrno,constr,opt,result,verified)<0){
+        free(result); free(verified); return NULL;
+    }
+    for(k=0;k<5;k++) cnt[k]=0;
+    for(i=0;i<n;i++){
+        for(k=4;k>0 && result[i]!=decided_code[k];k--);
+        cnt[k]++;
+    }
+    for(best=1,k=2;k<5;k++) if(cnt[k]>cnt[best]) best=k;
+    for(i=0;i<n;i++) // the weakest verification among the majority
+        if(result[i]==decided_code[best] && verified[i]>lp_verified)
+            lp_verified=verified[i];
+    free(result); free(verified);
+    lp_consensus.solvers=n;
+    lp_consensus.agree=cnt[best];
+    lp_consensus.differ=n-cnt[0]-cnt[best];
+    lp_consensus.failed=cnt[0];
+    if(cnt[best]==0) return solver_msg; // all failed
+    for(k=1;k<5;k++) if(k!=best && cnt[k]==cnt[best])
+        return "solvers disagree, there is no majority verdict";
+    return decided_code[best];
+}
+
+/*---------------------------------------------------------*/
+/* Symmetry reduction
+   If a permutation of the final variables maps the goal to itself and
+   each constraint column to a positive multiple of a constraint column,
+   then it suffices to look for solutions which are invariant under the
+   group of such permutations, see symmetry.h. Rows in the same orbit
+   are added up, and so are the column entries; columns which become
+   zero or identical to an earlier one are dropped. The reduced LP
+   depends on the goal, thus it is built for a single check and is
+   not kept as the session LP. */
+static minitip_THREAD int *sym_orbit=NULL;	/* subset -> row of the reduced LP */
+static minitip_THREAD struct {
+    int n,nz;			/* number of columns and entries */
+    int *start;			/* column j is in start[j]..start[j+1]-1 */
+    int *type;			/* GLP_LO or GLP_FR */
+    int *row; double *val;	/* entries */
+    int *hash,hmask;		/* hash table of columns, -1: empty */
+} sym;
+
+static void sym_release(void)
+{   if(sym.start) free(sym.start);
+    if(sym.type) free(sym.type);
+    if(sym.row) free(sym.row);
+    if(sym.val) free(sym.val);
+    if(sym.hash) free(sym.hash);
+    memset(&sym,0,sizeof(sym));
+}
+/* space for maxcol columns with maxnz entries; return 1 if no memory */
+static int sym_alloc(int maxcol, int maxnz)
+{int i;
+    memset(&sym,0,sizeof(sym));
+    for(sym.hmask=1;sym.hmask<2*maxcol;sym.hmask<<=1);
+    sym.start=malloc((maxcol+2)*sizeof(int));
+    sym.type=malloc((maxcol+2)*sizeof(int));
+    sym.row=malloc((maxnz+1)*sizeof(int));
+    sym.val=malloc((maxnz+1)*sizeof(double));
+    sym.hash=malloc(sym.hmask*sizeof(int));
+    if(!sym.start || !sym.type || !sym.row || !sym.val || !sym.hash){
+        sym_release(); return 1;
+    }
+    for(i=0;i<sym.hmask;i++) sym.hash[i]=-1;
+    sym.hmask--; sym.start[0]=1; // glp_load_matrix() starts from 1
+    return 0;
+}
+/* add the column with entries set[],coeff[] (subsets) to the reduced
+   LP unless it is zero or is there already */
+static void sym_add_column(int n, const int set[], const double coeff[], int type)
+{int i,k,m,r,*row; double v,*val; unsigned h; long long lv;
+    row=sym.row+sym.start[sym.n]; val=sym.val+sym.start[sym.n];
+    for(m=0,i=0;i<n;i++){ // add up entries in the same orbit
+        r=sym_orbit[set[i]];
+        for(k=0;k<m && row[k]!=r;k++);
+        if(k==m){ row[m]=r; val[m]=0.0; m++; }
+        val[k] += coeff[i];
+    }
+    for(n=0,i=0;i<m;i++){ // drop zeros, sort by row
+        if(val[i]==0.0) continue;
+        r=row[i]; v=val[i];
+        for(k=n;k>0 && row[k-1]>r;k--){ row[k]=row[k-1]; val[k]=val[k-1]; }
+        row[k]=r; val[k]=v; n++;
+    }
+    if(n==0) return;
+    for(h=type,i=0;i<n;i++){
+        lv=(long long)(val[i]*1024.0);
+        h=h*31u+(unsigned)row[i]; h=h*31u+(unsigned)lv;
+    }
+    for(h&=sym.hmask;sym.hash[h]>=0;h=(h+1)&sym.hmask){
+        k=sym.hash[h];
+        if(sym.type[k]!=type || sym.start[k+1]-sym.start[k]!=n) continue;
+        for(i=0;i<n && sym.row[sym.start[k]+i]==row[i] &&
+                sym.val[sym.start[k]+i]==val[i];i++);
+        if(i==n) return; // the same column
+    }
+    sym.hash[h]=sym.n; sym.type[sym.n]=type;
+    sym.n++; sym.start[sym.n]=sym.start[sym.n-1]+n;
+}
+
+/* build the symmetry reduced LP in P, set rowperm to sym_orbit.
+   Returns 0 if done, 1 if no symmetry was found or out of memory. */
+static int build_symmetric_lp(int constrno, struct constraint_t *const constr[])
+{int i,j,k,t,n,ncols,nterm,norb,*set,*ja,srow[4]; double *goal,*coeff,sval[4];
+ struct sym_column_t *sc; const struct constraint_t *c;
+    for(i=0,ncols=0,nterm=0;i<constrno;i++){
+        ncols+=constr[i]->cols; nterm+=constr[i]->n;
+    }
+    goal=calloc(rows+1,sizeof(double));
+    sc=malloc((ncols+1)*sizeof(struct sym_column_t));
+    set=malloc((nterm+1)*sizeof(int));
+    coeff=malloc((nterm+1)*sizeof(double));
+    sym_orbit=malloc((rows+1)*sizeof(int));
+    norb=-1;
+    if(goal && sc && set && coeff && sym_orbit){
+        for(i=0;i<entropy_expr.n;i++)
+            goal[varmask(entropy_expr.item[i].var)] += entropy_expr.item[i].coeff;
+        for(i=0,k=0,n=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++,k++){
+            c=constr[i];
+            sc[k].free = c->col[j].type==ent_eq;
+            sc[k].n=c->col[j].to-c->col[j].from;
+            sc[k].set=set+n; sc[k].coeff=coeff+n;
+            for(t=c->col[j].from;t<c->col[j].to;t++,n++){
+                set[n]=varmask(c->item[t].gvar); coeff[n]=c->item[t].coeff;
+            }
         }
+        norb=symmetry_orbits(var_no,goal,ncols,sc,sym_orbit);
     }
-    /* release allocated memory */
-    release_glp();
+    if(norb>0 && norb<rows && !sym_alloc(cols+ncols,4*shannon+2*var_no+nterm)){
+        for(i=0;i<cols;i++){
+            n=shannon_column(i,srow,sval);
+            sym_add_column(n,srow,sval,GLP_LO);
+        }
+        for(k=0;k<ncols;k++)
+            sym_add_column(sc[k].n,sc[k].set,sc[k].coeff,sc[k].free ? GLP_FR : GLP_LO);
+        ja=malloc(sym.start[sym.n]*sizeof(int));
+        if(ja){
+            for(j=0;j<sym.n;j++) for(t=sym.start[j];t<sym.start[j+1];t++) ja[t]=j+1;
+            invalidate_lp(); // the session LP is lost
+            P=glp_create_prob();
+            glp_add_rows(P,norb); glp_add_cols(P,sym.n);
+            glp_load_matrix(P,sym.start[sym.n]-1,sym.row,ja,sym.val);
+            free(ja);
+            for(i=0;i<=sym.n;i++) glp_set_obj_coef(P,i,0.0);
+            glp_set_obj_dir(P,GLP_MIN);
+            for(j=1;j<=sym.n;j++) glp_set_col_bnds(P,j,sym.type[j-1],0.0,0.0);
+            for(i=1;i<=norb;i++) glp_set_row_bnds(P,i,GLP_FX,0.0,0.0);
+            goal_n=0; rowperm=sym_orbit;
+        } else norb=-1;
+        sym_release();
+    } else norb=-1;
+    if(goal) free(goal);
+    if(sc) free(sc);
+    if(set) free(set);
+    if(coeff) free(coeff);
+    if(norb<0 && sym_orbit){ free(sym_orbit); sym_orbit=NULL; }
+    return norb<0;
+}
+
+/* solve the symmetry reduced LP; NULL if there is no symmetry or the
+   solver failed, then the full LP should be used */
+static char *solve_symmetric(int constrno, struct constraint_t *const constr[],
+       const struct lp_options_t *opt)
+{char *retval; int err;
+    lp_stats_start(STAT_BUILD);
+    err=build_symmetric_lp(constrno,constr);
+    lp_stats_stop(STAT_BUILD);
+    if(err) return NULL;
+    retval=solve_goal(0,opt,0);
+    release_glp(); rowperm=NULL;
+    free(sym_orbit); sym_orbit=NULL;
+    if(decided(retval)) return retval;
+    lp_verified=VERIFY_NONE;
+    return NULL;
+}
+
+/*---------------------------------------------------------*/
+/* Lazy column generation
+   With many variables most Shannon inequalities are never used. The
+   LP used here is
+        maximize t  subject to  A x = t g,  0 <= t <= 1
+   where x>=0 on Shannon and >= constraint columns, and free on =
+   constraint columns. Its optimum is 1 if the goal g follows, and 0
+   otherwise. It is solved first with the constraint columns and the
+   Shannon inequalities with empty condition. The row duals y price
+   every Shannon column in closed form; those with y*A_j<0 would
+   improve the objective. The most violated ones are added, and the LP
+   is solved again from the last basis. When no column prices out, the
+   optimum is that of the full LP. */
+#define LAZY_EPS	1e-9	/* tolerance when pricing */
+
+static minitip_THREAD char *lazy_in=NULL;	/* Shannon column idx is in the LP */
+static minitip_THREAD struct lazy_cand_t {
+    int idx;			/* Shannon column */
+    double d;			/* its price */
+} *lazy_cand=NULL;		/* columns pricing out */
+
+static void lazy_release(void)
+{   release_glp();
+    if(lazy_in){ free(lazy_in); lazy_in=NULL; }
+    if(lazy_cand){ free(lazy_cand); lazy_cand=NULL; }
+    if(rowperm){ free(rowperm); rowperm=NULL; }
+}
+/* add the idx-th Shannon inequality to P as a new column */
+static void lazy_add(int idx)
+{int k,n;
+    n=shannon_column(idx,row_idx+1,row_val+1);
+    for(k=1;k<=n;k++) row_idx[k]=rowperm[row_idx[k]];
+    add_column(glp_add_cols(P,1),n,GLP_LO);
+    lazy_in[idx]=1;
+}
+static int cmp_cand(const void *a, const void *b)
+{double da=((const struct lazy_cand_t*)a)->d, db=((const struct lazy_cand_t*)b)->d;
+    return da<db ? -1 : da>db ? 1 : 0;
+}
+/* price the Shannon columns not in P by the row duals y[]; add at
+   most rows of them, the most violated first. Return the number of
+   columns added */
+static int lazy_price(const double y[])
+{int idx,k,n,cnt,r[4]; double v[4],d;
+    for(idx=0,cnt=0;idx<cols;idx++){
+        if(lazy_in[idx]) continue;
+        n=shannon_column(idx,r,v);
+        for(d=0.0,k=0;k<n;k++) d+=v[k]*y[rowperm[r[k]]];
+        if(d< -LAZY_EPS){ lazy_cand[cnt].idx=idx; lazy_cand[cnt].d=d; cnt++; }
+    }
+    if(cnt>rows){
+        qsort(lazy_cand,cnt,sizeof(struct lazy_cand_t),cmp_cand);
+        cnt=rows;
+    }
+    for(k=0;k<cnt;k++) lazy_add(lazy_cand[k].idx);
+    return cnt;
+}
+
+/* create the starting LP in P. Returns 1 if out of memory */
+static int build_lazy_lp(int constrno, struct constraint_t *const constr[])
+{int i,j,k,n; const struct constraint_t *c;
+    invalidate_lp(); // the session LP is lost
+    lazy_in=calloc(cols,1);
+    lazy_cand=malloc(cols*sizeof(struct lazy_cand_t));
+    rowperm=malloc((rows+1)*sizeof(int));
+    if(!lazy_in || !lazy_cand || !rowperm){ lazy_release(); return 1; }
+    for(i=0;i<=rows;i++){rowperm[i]=i;} perm_array(rows+1,rowperm);
+    P=glp_create_prob();
+    glp_set_obj_dir(P,GLP_MAX);
+    glp_add_rows(P,rows);
+    for(i=1;i<=rows;i++) glp_set_row_bnds(P,i,GLP_FX,0.0,0.0);
+    glp_add_cols(P,1); // column of t, its entries are -g
+    glp_set_col_bnds(P,1,GLP_DB,0.0,1.0);
+    glp_set_obj_coef(P,1,1.0);
+    for(i=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++){
+        c=constr[i];
+        for(k=c->col[j].from,n=0;k<c->col[j].to;k++){
+            n++; row_idx[n]=varidx(c->item[k].gvar); row_val[n]=c->item[k].coeff;
+        }
+        add_column(glp_add_cols(P,1),n,c->col[j].type==ent_eq ? GLP_FR : GLP_LO);
+    }
+    for(i=0;i<var_no;i++) lazy_add(shannon+i);        // N-{i} <= N
+    for(i=0;i<var_no*(var_no-1)/2;i++) lazy_add(i<<(var_no-2)); // (i,j)>=0
+    return 0;
+}
+
+/* solve the lazy LP for goal sign*g */
+static char *lazy_goal(double sign, const struct lp_options_t *opt)
+{int i; char *retval; double *y; time_t start;
+    lp_solver->reset();
+    glp_set_mat_col(P,1,goal_rows(-sign),row_idx,row_val);
+    y=malloc((rows+1)*sizeof(double));
+    if(!y) return "the problem is too large, not enough memory";
+    init_glp_parameters(opt->iterlimit,opt->timelimit);
+    parm.meth=GLP_PRIMAL; parm.presolve=GLP_OFF; // keep the basis
+    start=time(NULL);
+    for(;;){
+        retval=invoke_lp();
+        if(retval!=EXPR_TRUE){ // the LP is always feasible
+            if(retval==EXPR_FALSE) retval=glp_status_msg(GLP_NOFEAS);
+            break;
+        }
+        if(lp_solver->obj_val(P)>0.5) break; // EXPR_TRUE
+        for(i=1;i<=rows;i++) y[i]=lp_solver->row_dual(P,i);
+        lp_stats_start(STAT_BUILD);
+        i=lazy_price(y);
+        lp_stats_stop(STAT_BUILD);
+        if(i==0){ retval=EXPR_FALSE; break; }
+        if(time(NULL)-start>opt->timelimit){
+            retval=glp_return_msg(GLP_ETMLIM); break;
+        }
+    }
+    free(y);
+    return retval;
+}
+
+/* check the goal by lazy column generation */
+static char *solve_lazy(int constrno, struct constraint_t *const constr[],
+       const struct lp_options_t *opt)
+{char *retval; int err;
+    lp_stats_start(STAT_BUILD);
+    err=build_lazy_lp(constrno,constr);
+    lp_stats_stop(STAT_BUILD);
+    if(err) return "the problem is too large, not enough memory";
+    retval=lazy_goal(1.0,opt);
+    if(entropy_expr.type==ent_eq && (retval==EXPR_TRUE || retval==EXPR_FALSE))
+        retval=eq_verdict(retval,lazy_goal(-1.0,opt));
+    lazy_release();
+    return retval;
+}
+
+/*---------------------------------------------------------*/
+/* Dual formulation
+   By Farkas' lemma the goal g is a nonnegative combination of the
+   columns if and only if g*h >= 0 for every h with A_j*h >= 0 for the
+   Shannon and >= constraint columns, and A_j*h = 0 for the = ones. The
+   LP used here is
+        minimize g*h  subject to these and  g*h >= -1
+   where h is free. h=0 is feasible; the optimum is 0 if the goal
+   follows, and -1 otherwise, when h is a polymatroid satisfying the
+   constraints but not the goal. The columns of this LP are the subsets
+   and the rows are the inequalities, thus it has far fewer columns
+   than rows. It is built for a single check. */
+static minitip_THREAD int dual_goal_row;	/* the row g*h >= -1 */
+
+static void dual_release(void)
+{   release_glp();
     if(rowperm){ free(rowperm); rowperm=NULL; }
-    if(colperm){ free(colperm); colperm=NULL; }
+}
+
+/* create the dual LP in P. Returns 1 if out of memory */
+static int build_dual_lp(int constrno, struct constraint_t *const constr[])
+{int i,j,k,n,r,nz,*ia,*ja; double *ar; const struct constraint_t *c;
+    invalidate_lp(); // the session LP is lost
+    for(i=0,nz=4*shannon+2*var_no,r=cols;i<constrno;i++){
+        nz+=constr[i]->n; r+=constr[i]->cols;
+    }
+    dual_goal_row=r+1;
+    rowperm=malloc((rows+1)*sizeof(int));
+    ia=malloc((nz+1)*sizeof(int));
+    ja=malloc((nz+1)*sizeof(int));
+    ar=malloc((nz+1)*sizeof(double));
+    if(!rowperm || !ia || !ja || !ar){
+        if(ia) free(ia);
+        if(ja) free(ja);
+        if(ar) free(ar);
+        dual_release(); return 1;
+    }
+    for(i=0;i<=rows;i++){rowperm[i]=i;} perm_array(rows+1,rowperm);
+    P=glp_create_prob();
+    glp_set_obj_dir(P,GLP_MIN);
+    glp_add_cols(P,rows); glp_add_rows(P,dual_goal_row);
+    for(i=1;i<=rows;i++) glp_set_col_bnds(P,i,GLP_FR,0.0,0.0);
+    for(r=1,nz=0;r<=cols;r++){ // Shannon inequalities
+        n=shannon_column(r-1,ja+nz+1,ar+nz+1);
+        for(k=1;k<=n;k++){ ia[nz+k]=r; ja[nz+k]=rowperm[ja[nz+k]]; }
+        nz+=n;
+        glp_set_row_bnds(P,r,GLP_LO,0.0,0.0);
+    }
+    for(i=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++,r++){
+        c=constr[i];
+        for(k=c->col[j].from;k<c->col[j].to;k++){
+            nz++; ia[nz]=r; ja[nz]=varidx(c->item[k].gvar); ar[nz]=c->item[k].coeff;
+        }
+        glp_set_row_bnds(P,r,c->col[j].type==ent_eq ? GLP_FX : GLP_LO,0.0,0.0);
+    }
+    glp_load_matrix(P,nz,ia,ja,ar);
+    free(ia); free(ja); free(ar);
+    glp_set_row_bnds(P,dual_goal_row,GLP_LO,-1.0,0.0);
+    return 0;
+}
+
+/* solve the dual LP for goal sign*g; warm: keep the last basis */
+static char *dual_goal(double sign, const struct lp_options_t *opt, int warm)
+{int i,n; char *retval;
+    lp_solver->reset(); // the goal row changes
+    for(i=1;i<=rows;i++) glp_set_obj_coef(P,i,0.0);
+    n=goal_rows(sign);
+    for(i=1;i<=n;i++) glp_set_obj_coef(P,row_idx[i],row_val[i]);
+    glp_set_mat_row(P,dual_goal_row,n,row_idx,row_val);
+    init_glp_parameters(opt->iterlimit,opt->timelimit);
+    if(warm) parm.presolve=GLP_OFF;
+    retval=invoke_lp();
+    if(retval==EXPR_TRUE) // optimum is 0 or -1
+        retval = lp_solver->obj_val(P) < -0.5 ? EXPR_FALSE : EXPR_TRUE;
+    else if(retval==EXPR_FALSE) // h=0 is always feasible
+        retval=glp_status_msg(GLP_NOFEAS);
+    return retval;
+}
+
+/* check the goal using the dual LP */
+static char *solve_dual(int constrno, struct constraint_t *const constr[],
+       const struct lp_options_t *opt)
+{char *retval; int err;
+    lp_stats_start(STAT_BUILD);
+    err=build_dual_lp(constrno,constr);
+    lp_stats_stop(STAT_BUILD);
+    if(err) return "the problem is too large, not enough memory";
+    lp_formulation=LP_DUAL;
+    retval=dual_goal(1.0,opt,0);
+    if(entropy_expr.type==ent_eq && (retval==EXPR_TRUE || retval==EXPR_FALSE))
+        retval=eq_verdict(retval,dual_goal(-1.0,opt,1));
+    dual_release();
+    return retval;
+}
+
+/* whether the dual LP should be used. Verification, certificates and
+   the parallel solvers need the primal LP. The automatic choice takes
+   the dual LP when there are many variables and few constraints,
+   unless the symmetry reduced or the lazy LP is used. */
+minitip_THREAD int lp_formulation;
+static int use_dual(int constrno, struct constraint_t *const constr[],
+       const struct lp_options_t *opt)
+{int i,n;
+    if(opt->formulation==LP_PRIMAL || opt->verify || opt->cert ||
+       opt->portfolio>1 || opt->consensus>1) return 0;
+    if(opt->formulation==LP_DUAL) return 1;
+    if(opt->symmetry || var_no<DUAL_AUTO_VARNO ||
+       (opt->lazy && var_no>=opt->lazy)) return 0;
+    for(i=0,n=0;i<constrno;i++) n+=constr[i]->cols;
+    return n<=var_no;
+}
+
+/*---------------------------------------------------------*/
+/* The built-in simplex method (simplex.c) works on subsets directly
+   and does not build the LP; Shannon columns are generated on the fly.
+   Only the constraint columns and the goal are passed to it. */
+static char *builtin_msg(int code)
+{   switch(code){
+  case SPLX_FEASIBLE:   return EXPR_TRUE;
+  case SPLX_INFEASIBLE: return EXPR_FALSE;
+  case SPLX_ITLIM:      return "iteration limit exceeded";
+  case SPLX_TMLIM:      return "time limit exceeded";
+  case SPLX_NOMEM:      return "too many variables for the built-in solver";
+    }
+    return "numerical instability";
+}
+
+/* call the built-in solver, record the work done */
+static int builtin_goal(int ncols, const struct splx_column_t sc[],
+       const double goal[], const struct lp_options_t *opt)
+{int code;
+    lp_stats_start(STAT_SOLVE);
+    code=splx_solve(var_no,ncols,sc,goal,opt->iterlimit,opt->timelimit);
+    lp_stats_stop(STAT_SOLVE);
+    lp_stats.iterations+=splx_iterations;
+    return code;
+}
+
+static char *solve_builtin(int constrno, struct constraint_t *const constr[],
+       const struct lp_options_t *opt)
+{int i,j,k,t,n,ncols,nterm,*set; double *goal,*coeff; char *retval;
+ struct splx_column_t *sc; const struct constraint_t *c;
+    if(var_no>SPLX_MAX_VARNO) return builtin_msg(SPLX_NOMEM);
+    for(i=0,ncols=0,nterm=0;i<constrno;i++){
+        ncols+=constr[i]->cols; nterm+=constr[i]->n;
+    }
+    goal=calloc(rows+1,sizeof(double));
+    sc=malloc((ncols+1)*sizeof(struct splx_column_t));
+    set=malloc((nterm+1)*sizeof(int));
+    coeff=malloc((nterm+1)*sizeof(double));
+    retval="the problem is too large, not enough memory";
+    if(goal && sc && set && coeff){
+        for(i=0,k=0,n=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++,k++){
+            c=constr[i];
+            sc[k].free = c->col[j].type==ent_eq;
+            sc[k].n=c->col[j].to-c->col[j].from;
+            sc[k].row=set+n; sc[k].val=coeff+n;
+            for(t=c->col[j].from;t<c->col[j].to;t++,n++){
+                set[n]=varmask(c->item[t].gvar); coeff[n]=c->item[t].coeff;
+            }
+        }
+        for(i=0;i<entropy_expr.n;i++)
+            goal[varmask(entropy_expr.item[i].var)] += entropy_expr.item[i].coeff;
+        lp_stats.rows=rows; lp_stats.cols=cols+ncols;
+        lp_stats.nonzeros=4*shannon-var_no*(var_no-1)/2+2*var_no+nterm;
+        retval=builtin_msg(builtin_goal(ncols,sc,goal,opt));
+        if(entropy_expr.type==ent_eq && (retval==EXPR_TRUE || retval==EXPR_FALSE)){
+            for(i=1;i<=rows;i++) goal[i] = -goal[i];
+            retval=eq_verdict(retval,builtin_msg(builtin_goal(ncols,sc,goal,opt)));
+        }
+    }
+    if(goal) free(goal);
+    if(sc) free(sc);
+    if(set) free(set);
+    if(coeff) free(coeff);
+    return retval;
+}
+
+/*---------------------------------------------------------*/
+/* Result cache
+   The key is the canonical form of the goal and the constraint
+   columns over the final variables, see cache.h. Decided verdicts are
+   stored as their index in decided_code[]. */
+static char *result_key(int constrno, struct constraint_t *const constr[])
+{int i,j,k,t,n,ncols,nterm,*set,*gset; double *coeff,*gcoeff; char *key;
+ struct cache_column_t *cc; const struct constraint_t *c;
+    for(i=0,ncols=0,nterm=0;i<constrno;i++){
+        ncols+=constr[i]->cols; nterm+=constr[i]->n;
+    }
+    cc=malloc((ncols+1)*sizeof(struct cache_column_t));
+    set=malloc((nterm+1)*sizeof(int));
+    coeff=malloc((nterm+1)*sizeof(double));
+    gset=malloc((entropy_expr.n+1)*sizeof(int));
+    gcoeff=malloc((entropy_expr.n+1)*sizeof(double));
+    key=NULL;
+    if(cc && set && coeff && gset && gcoeff){
+        for(i=0,k=0,n=0;i<constrno;i++) for(j=0;j<constr[i]->cols;j++,k++){
+            c=constr[i];
+            cc[k].free = c->col[j].type==ent_eq;
+            cc[k].n=c->col[j].to-c->col[j].from;
+            cc[k].set=set+n; cc[k].coeff=coeff+n;
+            for(t=c->col[j].from;t<c->col[j].to;t++,n++){
+                set[n]=varmask(c->item[t].gvar); coeff[n]=c->item[t].coeff;
+            }
+        }
+        for(i=0;i<entropy_expr.n;i++){
+            gset[i]=varmask(entropy_expr.item[i].var);
+            gcoeff[i]=entropy_expr.item[i].coeff;
+        }
+        key=cache_key(var_no,entropy_expr.type==ent_eq,entropy_expr.n,
+                      gset,gcoeff,ncols,cc);
+    }
+    if(cc) free(cc);
+    if(set) free(set);
+    if(coeff) free(coeff);
+    if(gset) free(gset);
+    if(gcoeff) free(gcoeff);
+    return key;
+}
+
+/* solve the LP after the variables have been assigned */
+static char *solve_lp(int constrno, struct constraint_t *const constr[],
+              const struct lp_options_t *opt)
+{int warm,which; char *retval;
+    which=opt->solver;
+    if(which==LP_BUILTIN){ // does not use glpk, no certificate or verification
+        if(!opt->cert && !opt->verify) return solve_builtin(constrno,constr,opt);
+        which=0;
+    }
+    if(!lp_get_solver(which))
+        return "this LP solver is not compiled into minitip";
+    if(lp_solver!=lp_get_solver(which)){ // a new backend
+        if(lp_solver) lp_solver->reset();
+        lp_solver=lp_get_solver(which);
+    }
+    if(use_dual(constrno,constr,opt))
+        return solve_dual(constrno,constr,opt);
+    if(opt->symmetry && !opt->cert && (retval=solve_symmetric(constrno,constr,opt)))
+        return retval;
+    if(opt->lazy && var_no>=opt->lazy && !opt->verify && !opt->cert)
+        return solve_lazy(constrno,constr,opt);
+    warm=session_match(constrno,constr);
+    if(warm){
+        rowperm=skeleton[var_no].rowperm;
+    } else {
+        invalidate_lp();
+        if((retval=build_lp(constrno,constr))) return retval;
+    }
+    retval=NULL;
+    if(opt->cert) // the certificate is written by this process
+        cert_header(opt->cert);
+    else if(opt->consensus>1)
+        retval=run_consensus(warm,constrno,constr,opt);
+    else if(opt->portfolio>1)
+        retval=run_portfolio(warm,constrno,constr,opt);
+    if(retval==NULL)
+        retval=solve_goal(warm,opt,0);
+    if(warm && !decided(retval)){ // try again from scratch
+        invalidate_lp();
+        if((retval=build_lp(constrno,constr))) return retval;
+        warm=0; retval=solve_goal(warm,opt,0);
+    }
+    if(!decided(retval)){
+        invalidate_lp();
+        drop_skeleton(); // try another permutation next time
+    } else if(!warm){
+        session_save(constrno,constr);
+    }
+    return retval;
+}
+
+char *call_lp(int constrno, struct constraint_t *const constr[],
+              const struct lp_options_t *opt)
+{int i,j,n; char *retval,*key;
+    /* the expression to be checked is in entropy_expr.
+       determine first the variables */
+    lp_stats_start(STAT_VARS);
+    init_var_assignment(); /* start collecting variables */
+    add_expr_variables();  /* variables in the expression to be checked */
+    for(i=0;i<constrno;i++){ /* go over all constraints */
+        for(j=0;j<constr[i]->n;j++) add_var(constr[i]->item[j].gvar);
+    }
+    /* figure out final variables, rows, cols, number of Shannon */
+    i=do_variable_assignment();
+    lp_stats_stop(STAT_VARS);
+    if(i){ // number of variables is less than 2
+        return "number of final random variables is less than 2";
+    }
+    lp_stats.var_no=var_no;
+    /* room for the goal and the longest constraint column */
+    for(i=0,n=entropy_expr.n;i<constrno;i++) for(j=0;j<constr[i]->cols;j++){
+        if(n<constr[i]->col[j].to-constr[i]->col[j].from)
+            n=constr[i]->col[j].to-constr[i]->col[j].from;
+    }
+    if(!row_room(n)) return "the problem is too large, not enough memory";
+    lp_consensus.solvers=0; lp_verified=VERIFY_NONE;
+    lp_formulation=LP_PRIMAL;
+    key=NULL;
+    if(opt->cache && !opt->verify && !opt->cert && opt->consensus<=1){
+        lp_stats_start(STAT_VARS);
+        key=result_key(constrno,constr);
+        i= key ? cache_lookup(key) : 0;
+        lp_stats_stop(STAT_VARS);
+        if(i>0 && i<5){
+            free(key); lp_stats.cached=1;
+            return decided_code[i];
+        }
+    }
+    retval=solve_lp(constrno,constr,opt);
+    if(key){
+        for(i=1;i<5;i++) if(retval==decided_code[i]) cache_store(key,i);
+        free(key);
+    }
     return retval;
 }
 
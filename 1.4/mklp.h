@@ -17,13 +17,117 @@
 #define EQ_GE_ONLY	((char*)0x4)
 #define EQ_LE_ONLY	((char*)0x5)
 
-/* call the lp routine. Initially the expression to be checked
-   is in the struct entropy_expr (with all variables set properly).
-   Calling next_expr(i) puts the i-th constraint there, or returns
-   1 if there are no more constraints.
+/* the built-in simplex method, see simplex.h */
+#define LP_BUILTIN	2
+
+/* lazy=auto uses column generation from this many variables */
+#define LAZY_AUTO_VARNO	11
+
+/* LP formulations. formulation=auto uses the dual LP from this many
+   variables if there are at most var_no constraint columns */
+#define LP_PRIMAL	0	/* the goal is a combination of columns */
+#define LP_DUAL		1	/* no polymatroid violates the goal */
+#define LP_AUTO		2	/* choose one of them */
+#define DUAL_AUTO_VARNO	7
+
+/* parameters of the LP solver */
+struct lp_options_t {
+    int solver;		/* 0: glpk, 1: HiGHS, LP_BUILTIN */
+    int iterlimit;	/* iteration limit */
+    int timelimit;	/* time limit in seconds */
+    int portfolio;	/* number of differently configured solvers
+			   run in parallel; 1: no portfolio */
+    int consensus;	/* number of permuted and scaled instances
+			   solved in parallel; 1: no consensus */
+    int verify;		/* check the verdict in exact arithmetic */
+    int symmetry;	/* reduce the LP by variable symmetries */
+    int lazy;		/* generate Shannon columns on demand from this
+			   many variables; 0: never */
+    int formulation;	/* LP_PRIMAL, LP_DUAL or LP_AUTO */
+    int cache;		/* look up and store the verdict in the result
+			   cache, see cache.h; not used with verify,
+			   cert or consensus */
+    FILE *cert;		/* if not NULL, write the certificate here;
+			   no portfolio or consensus is used */
+};
+
+/* call the lp routine. The expression to be checked is in the
+   struct entropy_expr, constr[0..constrno-1] are the compiled
+   constraints; all of them are bound to the same identifier table.
    Return value: EXPR_TRUE, EXPR_FALSE, or an error string for
    other errors (such as out of memory, LP problem, etc) */
-char *call_lp(int next_expr(int),int iterlimit,int timelimit);
+struct constraint_t;
+char *call_lp(int constrno, struct constraint_t *const constr[],
+              const struct lp_options_t *opt);
+
+/* after call_lp() in consensus mode: the number of solvers, how many
+   of them gave the returned verdict, a different verdict, or failed.
+   solvers is zero if the last call was not in consensus mode. */
+struct lp_consensus_t {
+    int solvers, agree, differ, failed;
+};
+extern minitip_THREAD struct lp_consensus_t lp_consensus;
+
+/* after call_lp() with verification: how the verdict was checked */
+#define VERIFY_NONE	0	/* not checked */
+#define VERIFY_CERT	1	/* rounded solution is a proof */
+#define VERIFY_EXACT	2	/* confirmed by the exact simplex method */
+#define VERIFY_FIXED	3	/* corrected by the exact simplex method */
+#define VERIFY_FAILED	4	/* could not be verified */
+extern minitip_THREAD int lp_verified;
+
+/* after call_lp(): the formulation which was solved, LP_PRIMAL or
+   LP_DUAL */
+extern minitip_THREAD int lp_formulation;
+
+/* statistics of the last check: wall and CPU time of the phases in
+   seconds, size of the LP solved last, simplex iterations, the peak
+   memory used by glpk, and whether the result cache answered.
+   Solvers running in forked processes are not counted.
+   lp_stats_reset() clears them; a phase is timed by calling
+   lp_stats_start() and lp_stats_stop(). */
+#define STAT_PARSE	0	/* parsing, binding the constraints */
+#define STAT_VARS	1	/* merging variables, cache lookup */
+#define STAT_BUILD	2	/* building the LP */
+#define STAT_SOLVE	3	/* the LP solver, glpk presolve included */
+#define STAT_VERIFY	4	/* exact verification */
+#define STAT_PHASES	5
+struct lp_stats_t {
+    double wall[STAT_PHASES], cpu[STAT_PHASES];
+    int var_no;			/* final random variables */
+    int rows, cols;		/* size of the LP */
+    long nonzeros;		/* nonzero matrix entries */
+    long iterations;		/* simplex iterations */
+    size_t mem_peak;		/* peak glpk memory in bytes */
+    int cached;			/* the verdict came from the cache */
+};
+extern minitip_THREAD struct lp_stats_t lp_stats;
+void lp_stats_reset(void);
+void lp_stats_start(int phase);
+void lp_stats_stop(int phase);
+
+/* the LP of the last check is kept and reused when the next check has
+   the same constraints. Call invalidate_lp() when the constraints are
+   changed, and to release the LP. */
+void invalidate_lp(void);
+
+/* LP state: the skeletons, the session LP, the backend in use, and
+   lp_stats, lp_consensus, lp_verified and lp_formulation of the last
+   check. The module works on one state at a time in each thread;
+   others can be saved and exchanged with it. The glpk problems of a
+   state belong to the thread which created them.
+   lp_state_new() returns an empty state, or NULL if out of memory;
+   lp_state_swap(s) exchanges the state of the module with s;
+   lp_state_stats(s) is the lp_stats of the saved state s;
+   lp_state_free(s) releases a saved state with its LPs;
+   lp_release_buffers() releases the column buffers and the glpk
+   environment of the calling thread, which must have no LP left. */
+struct lp_state_t;
+struct lp_state_t *lp_state_new(void);
+void lp_state_swap(struct lp_state_t *s);
+const struct lp_stats_t *lp_state_stats(const struct lp_state_t *s);
+void lp_state_free(struct lp_state_t *s);
+void lp_release_buffers(void);
 
 
 /* EOF */
@@ -37,7 +37,9 @@
 *   char  X_chr   the character at the X_pos position
 *
 */
-static const char *X_str; static char X_chr; static int X_pos;
+static minitip_THREAD const char *X_str;
+static minitip_THREAD char X_chr;
+static minitip_THREAD int X_pos;
 
 /***********************************************************************
 * Error structure, error routines and messages
@@ -59,7 +61,7 @@ static const char *X_str; static char X_chr; static int X_pos;
 *     argument is evaluated even when the condition is true. The #define
 *     form evaluates errmessage only when the condition is false.
 */
-struct syntax_error_t syntax_error;
+minitip_THREAD struct syntax_error_t syntax_error;
 static void softerr(char *err){
     if(!syntax_error.softerrstr){
       syntax_error.softerrstr=err; syntax_error.softerrpos=X_pos; }
@@ -86,7 +88,7 @@ inline static void adjust_error_position(int d)
 */
 #define e_TOO_MANY_ID	"too many different random variables (max " mkstringof(minitip_MAX_ID_NO) ")"
 #define e_TOO_LONG_ID	"too long identifier (max length=" mkstringof(minitip_MAX_ID_LENGTH) ")"
-#define e_TOO_LONG_EXPR	"the expanded expression is too long (max " mkstringof(minitip_MAX_EXPR_LENGTH) ")"
+#define e_TOO_LONG_EXPR	"out of memory while expanding the expression"
 #define e_TOO_MANY_ARGS "too many arguments (max " mkstringof(minitip_MAX_ID_NO) ")"
 #define e_TOO_MANY_MACRO "cannot add more macros, the maximum has been reached"
 #define e_NO_MEMORY	"out of memory while storing this macro"
@@ -153,7 +155,7 @@ inline static void adjust_error_position(int d)
 *   multiple times, so the first message is kept.
 */
 static char* e_FUNCTIONOF(int i){
-static char buf1[90],buf2[15]; char *txt;
+static minitip_THREAD char buf1[90],buf2[15]; char *txt;
     if(syntax_error.harderrstr) return "-";
     switch(i){
         case 0: txt="first"; break;
@@ -173,8 +175,10 @@ static char buf1[90],buf2[15]; char *txt;
 *   int     X_msr    additional measures: 0=yes, 1=no
 */
 
-static syntax_style_t X_style; static char X_sep;
-static int X_xvar; static int X_msr;
+static minitip_THREAD syntax_style_t X_style;
+static minitip_THREAD char X_sep;
+static minitip_THREAD int X_xvar;
+static minitip_THREAD int X_msr;
 #define SIMPLE		syntax_short
 #define ORIGINAL	syntax_full
 
@@ -182,9 +186,10 @@ void set_syntax_style(syntax_style_t style, char sep, int ext_var){
     X_style=style; X_sep=sep; X_xvar=ext_var; }
 /***********************************************************************
 * Macro expansion and storage routines
-*   expanded macro texts are stored in the macro_text[] array.
-*   A new definition fills out new_macro, which then can be copied
-*   into the main macro storage part.
+*   expanded macro texts are stored in the macro_text[] array. The
+*   bodies take exactly as many items as they have from the macro
+*   arena, a list of item blocks. Macro heads are looked up in the
+*   hash table macro_index[].
 *
 * int standard_macros
 *   number of standard macros (do not delete or overwrite)
@@ -198,7 +203,8 @@ void set_syntax_style(syntax_style_t style, char sep, int ext_var){
 *   add the new macro to the list of available macros. The macro body
 *   is in entropy_expr
 * void delete_macro_with_idx(int idx)
-*   delete the macro at the given slot.
+*   delete the macro at the given slot. The last macro is moved into
+*   the freed slot.
 */
 struct macro_head_t {
     int argno;		/* number of arguments */
@@ -209,19 +215,210 @@ struct macro_head_t {
 
 struct macro_text_t {
     struct macro_head_t head;   /* head */
-    struct entropy_expr_t *expr;/* the raw macro body */
+    int n;			/* number of items in the body */
+    struct entropy_item_t *item;/* the raw macro body in the arena */
 };
 
-static int max_macros=0;	/* size of macro table */
-static int standard_macros=0;	/* number of standard macros */
-int macro_total=0; 		/* total number of macros */
+static minitip_THREAD int max_macros=0;	/* size of macro table */
+static minitip_THREAD int standard_macros=0;	/* number of standard macros */
+minitip_THREAD int macro_total=0;	/* total number of macros */
 
-static struct macro_text_t *macro_text=NULL; // [minitip_MAX_MACRONO];
+static minitip_THREAD struct macro_text_t *macro_text=NULL; // [minitip_MAX_MACRONO];
+
+/***********************************************************************
+* The macro arena
+*   Bodies are allocated from the last block. A deleted body is given
+*   back only when it is at the end of the last block, otherwise it is
+*   wasted; when more than half of the arena is wasted, the live
+*   bodies are copied into a single new block.
+*
+* struct entropy_item_t *arena_alloc(int n)
+*   n consecutive items, or NULL if out of memory
+* void arena_release(struct entropy_item_t *item, int n)
+*   the body at item is not used any more
+* void arena_compact(void)
+*   copy the live bodies into a new block
+*/
+#define MACRO_BLOCK	4096	/* items in a block */
+
+struct macro_block_t {
+    struct macro_block_t *next;	/* the previous block */
+    int size, used;		/* number of items, used items */
+    struct entropy_item_t item[1];
+};
+
+static minitip_THREAD struct macro_block_t *macro_arena=NULL; /* the last block */
+static minitip_THREAD int arena_live=0, arena_waste=0; /* items in live, deleted bodies */
+
+static struct macro_block_t *new_block(int size)
+{struct macro_block_t *b;
+    if(size<MACRO_BLOCK) size=MACRO_BLOCK;
+    b=malloc(sizeof(struct macro_block_t)+(size-1)*sizeof(struct entropy_item_t));
+    if(b){ b->size=size; b->used=0; b->next=NULL; }
+    return b;
+}
+
+static void free_arena(struct macro_block_t *b)
+{struct macro_block_t *next;
+    for(;b;b=next){ next=b->next; free(b); }
+}
+
+static struct entropy_item_t *arena_alloc(int n)
+{struct macro_block_t *b;
+    if(macro_arena==NULL || macro_arena->size-macro_arena->used<n){
+        if((b=new_block(n))==NULL) return NULL;
+        if(macro_arena) arena_waste += macro_arena->size-macro_arena->used;
+        b->next=macro_arena; macro_arena=b;
+    }
+    b=macro_arena; b->used += n; arena_live += n;
+    return &b->item[b->used-n];
+}
+
+static void arena_release(struct entropy_item_t *item, int n)
+{   arena_live -= n;
+    if(item+n==&macro_arena->item[macro_arena->used])
+        macro_arena->used -= n;
+    else arena_waste += n;
+}
+
+static void arena_compact(void)
+{struct macro_block_t *b; int idx;
+    if((b=new_block(arena_live))==NULL) return; /* keep the old one */
+    for(idx=0;idx<macro_total;idx++){
+        memcpy(&b->item[b->used],macro_text[idx].item,
+               macro_text[idx].n*sizeof(struct entropy_item_t));
+        macro_text[idx].item=&b->item[b->used];
+        b->used += macro_text[idx].n;
+    }
+    free_arena(macro_arena); macro_arena=b;
+    arena_waste=0; arena_live=b->used;
+}
+
+/***********************************************************************
+* The macro index
+*   An open addressing hash table with linear probing. The key is
+*   (name,argno,septype); an empty slot has zero name. A key tells
+*     idx     the macro with this head, or -1
+*     prefix  the number of visible macros with more arguments whose
+*             first argno arguments and separators are as in the key
+*   the latter is used when a macro invocation is parsed. A key is
+*   removed when both are empty.
+*
+* struct macro_key_t *index_lookup(name,argno,septype)
+*   the key, or NULL if not present
+* struct macro_key_t *index_key(name,argno,septype)
+*   the key, added when necessary; NULL if out of memory
+* int index_reserve(int n)
+*   make room for n more keys; return 0 if out of memory
+* int index_macro(int idx, int add)
+*   add (or remove) the macro at slot idx; return 0 if out of memory
+* void index_rebuild(void)
+*   rebuild the index from scratch
+*/
+struct macro_key_t {
+    int argno, septype; char name;
+    int idx;		/* macro with this head, or -1 */
+    int prefix;		/* visible macros starting with this head */
+};
+
+static minitip_THREAD struct macro_key_t *macro_index=NULL;
+static minitip_THREAD int index_size=0, index_used=0;	/* size is a power of 2 */
+
+static unsigned index_hash(char name, int argno, int septype)
+{unsigned h;
+    h=((unsigned)name<<5)^(unsigned)argno;
+    h=h*0x9E3779B1u ^ (unsigned)septype;
+    h*=0x85EBCA6Bu;
+    return (h^(h>>15))&(index_size-1);
+}
+
+static int index_slot(char name, int argno, int septype)
+{int h; struct macro_key_t *k;
+    for(h=index_hash(name,argno,septype);;h=(h+1)&(index_size-1)){
+        k=&macro_index[h];
+        if(k->name==0 || (k->name==name && k->argno==argno &&
+             k->septype==septype)) return h;
+    }
+}
+
+static int index_reserve(int n)
+{struct macro_key_t *old; int oldsize,i,h;
+    if(2*(index_used+n)<=index_size) return 1;
+    old=macro_index; oldsize=index_size;
+    for(index_size=64;index_size<4*(index_used+n);index_size<<=1);
+    if((macro_index=calloc(index_size,sizeof(struct macro_key_t)))==NULL){
+        macro_index=old; index_size=oldsize; return 0;
+    }
+    for(i=0;i<oldsize;i++)if(old[i].name){
+        h=index_slot(old[i].name,old[i].argno,old[i].septype);
+        macro_index[h]=old[i];
+    }
+    if(old) free(old);
+    return 1;
+}
+
+static struct macro_key_t *index_lookup(char name, int argno, int septype)
+{int h;
+    if(index_size==0) return NULL;
+    h=index_slot(name,argno,septype);
+    return macro_index[h].name ? &macro_index[h] : NULL;
+}
+
+static struct macro_key_t *index_key(char name, int argno, int septype)
+{int h;
+    if(!index_reserve(1)) return NULL;
+    h=index_slot(name,argno,septype);
+    if(macro_index[h].name==0){
+        macro_index[h].name=name; macro_index[h].argno=argno;
+        macro_index[h].septype=septype;
+        macro_index[h].idx=-1; macro_index[h].prefix=0;
+        index_used++;
+    }
+    return &macro_index[h];
+}
+
+/* remove the key if empty; the keys after it are shifted back */
+static void index_tidy(struct macro_key_t *k)
+{int h,j,home,mask;
+    if(k->idx>=0 || k->prefix>0) return;
+    mask=index_size-1; h=k-macro_index;
+    macro_index[h].name=0; index_used--;
+    for(j=(h+1)&mask; macro_index[j].name; j=(j+1)&mask){
+        home=index_hash(macro_index[j].name,macro_index[j].argno,
+                        macro_index[j].septype);
+        if(j>h ? (home<=h || home>j) : (home<=h && home>j)){
+            macro_index[h]=macro_index[j]; macro_index[j].name=0; h=j;
+        }
+    }
+}
+
+static int index_macro(int idx, int add)
+{struct macro_head_t *head; struct macro_key_t *k; int a;
+    head=&macro_text[idx].head;
+    if(add && !index_reserve(head->argno+1)) return 0;
+    if((k=index_key(head->name,head->argno,head->septype))==NULL) return 0;
+    k->idx = add ? idx : -1; index_tidy(k);
+    if(head->hidden) return 1;
+    for(a=0;a<head->argno;a++){
+        if((k=index_key(head->name,a,head->septype&((1<<a)-1)))==NULL)
+            return 0;
+        k->prefix += add ? 1 : -1; index_tidy(k);
+    }
+    return 1;
+}
+
+static void index_rebuild(void)
+{int idx;
+    if(macro_index) memset(macro_index,0,index_size*sizeof(struct macro_key_t));
+    index_used=0;
+    for(idx=0;idx<macro_total;idx++) index_macro(idx,1);
+}
 
 void set_syntax_measure(int msr, int mfrom, int muntil)
 {   X_msr=msr==1 ? 0 : 1;
     standard_macros=muntil;
     for(;mfrom<muntil;mfrom++)macro_text[mfrom].head.hidden=X_msr;
+    index_rebuild();
 }
 
 int resize_macro_table(int newsize)
@@ -235,30 +432,39 @@ int resize_macro_table(int newsize)
     return max_macros;
 }
 inline static void add_new_macro(struct macro_head_t head)
-{int i; struct entropy_expr_t *e;
+{struct entropy_item_t *e;
     if(syntax_error.softerrstr|| syntax_error.harderrstr) return;
-    if((e = malloc(sizeof(struct entropy_expr_t)))==NULL){
+    if(macro_total>=max_macros) return;
+    if((e=arena_alloc(entropy_expr.n))==NULL){
          softerr(e_NO_MEMORY);
          return;
     }
+    memcpy(e,entropy_expr.item,entropy_expr.n*sizeof(struct entropy_item_t));
     macro_text[macro_total].head=head;
-    macro_text[macro_total].expr = e;
-    e->n = entropy_expr.n;
-    e->type = ent_mdef;
-    for(i=0;i<entropy_expr.n;i++){
-        e->item[i] = entropy_expr.item[i];
+    macro_text[macro_total].n=entropy_expr.n;
+    macro_text[macro_total].item=e;
+    if(!index_macro(macro_total,1)){ /* fails before changing the index */
+         arena_release(e,entropy_expr.n);
+         softerr(e_NO_MEMORY);
+         return;
     }
-    if(macro_total<max_macros) macro_total++;
+    macro_total++;
 }
 
 void delete_macro_with_idx(int idx)
-{   if(idx<0 || macro_total<=idx) return;
-    free(macro_text[idx].expr);
-    macro_total--;
-    while(idx<macro_total){
-        macro_text[idx]=macro_text[idx+1];
-        idx++;
+{struct macro_key_t *k; int last;
+    if(idx<0 || macro_total<=idx) return;
+    index_macro(idx,0);
+    arena_release(macro_text[idx].item,macro_text[idx].n);
+    last=macro_total-1;
+    if(idx<last){
+        macro_text[idx]=macro_text[last];
+        k=index_lookup(macro_text[idx].head.name,macro_text[idx].head.argno,
+                       macro_text[idx].head.septype);
+        if(k) k->idx=idx;
     }
+    macro_total--;
+    if(arena_waste>MACRO_BLOCK && arena_waste>arena_live) arena_compact();
 }
 /***********************************************************************
 * int find_macro(macro_head_t head, int partial)
@@ -273,36 +479,20 @@ void delete_macro_with_idx(int idx)
 *                 - 2 find partial match with last separator |
 *                 - -1 find exact match allowing hidden macros
 *
-*    return value: >=0 the macro's index; -1: no macro was found
+*    return value: >=0 the macro's index (0 for a partial match);
+*                  -1: no macro was found
 */
 static int find_macro(struct macro_head_t head, int partial)
-{int idx;
+{struct macro_key_t *k; int type;
     if(partial>0){
-        int mask=(1<<head.argno)-1;
-        int type=head.septype; if(partial==2) type |= 1<<(head.argno-1);
-        for(idx=0;idx<macro_total;idx++){
-            if(macro_text[idx].head.name == head.name &&
-               macro_text[idx].head.hidden == 0 &&
-               macro_text[idx].head.argno > head.argno &&
-               (macro_text[idx].head.septype&mask)==type ) return idx;
-        }
-        return -1;
+        type=head.septype; if(partial==2) type |= 1<<(head.argno-1);
+        k=index_lookup(head.name,head.argno,type&((1<<head.argno)-1));
+        return k && k->prefix>0 ? 0 : -1;
     } /* ask for exact match */
-    if(partial<0){ /* exact match allowing hidden macros */
-        for(idx=0;idx<macro_total;idx++){
-           if(macro_text[idx].head.name==head.name &&
-              macro_text[idx].head.argno == head.argno &&
-              macro_text[idx].head.septype == head.septype) return idx;
-        }
-        return -1;
-    }
-    for(idx=0;idx<macro_total;idx++){
-        if(macro_text[idx].head.name==head.name &&
-           macro_text[idx].head.hidden == 0 &&
-           macro_text[idx].head.argno == head.argno &&
-           macro_text[idx].head.septype == head.septype) return idx;
-    }
-    return -1;
+    k=index_lookup(head.name,head.argno,head.septype);
+    if(k==NULL || k->idx<0) return -1;
+    if(partial==0 && macro_text[k->idx].head.hidden) return -1;
+    return k->idx;
 }
 /***********************************************************************
 * int var_merge(int what, int from[] )
@@ -331,6 +521,19 @@ static int var_merge(int what, int from[])
 *     adds to the table if not found and the table is not full yet,
 *     issues a soft error otherwise
 *
+*  const char *get_idname(int i)
+*     the name of the i-th identifier, or NULL if there is no such.
+*
+*  void rank_ids(void)
+*     sort the identifiers alphabetically into id_order[] after the
+*     unknown ones (printed as "?"), and set up rank_bits(); done only
+*     when the identifier table has changed.
+*  unsigned rank_bits(int v)
+*     the variables of v as a bitmap where the alphabetically first
+*     identifier is the highest bit. Variable lists with the same
+*     number of elements compare as their sorted names when their
+*     rank bitmaps are compared in decreasing order.
+*
 *  char *get_idlist_repr(int v, int slot)
 *     Using v as a collection of random variables (taken as a bitmap),
 *     the textual representation of the random variables list is stored
@@ -339,14 +542,40 @@ static int var_merge(int what, int from[])
 *     to MAX_REPR_LENGTH (defined below). Too long list is illegible.
 */
 
-struct { char id[minitip_MAX_ID_LENGTH+1]; }id_table [minitip_MAX_ID_NO+1];
-static int id_table_idx=0; /* next empty slot */
-static char *no_new_id_str=NULL; /* add no new id */
+static minitip_THREAD struct { char id[minitip_MAX_ID_LENGTH+1]; }id_table [minitip_MAX_ID_NO+1];
+static minitip_THREAD int id_table_idx=0; /* next empty slot */
+static minitip_THREAD int id_version=0; /* increased when the table changes */
+static minitip_THREAD char *no_new_id_str=NULL; /* add no new id */
+
+/* identifiers are found through id_hash[]; an entry is the index of
+   the identifier, -1 if empty. Entries whose index is not below
+   id_table_idx or whose name differs are stale and skipped; the
+   table is rebuilt when half of it is used. */
+#define ID_HASH_SIZE	(4*minitip_MAX_ID_NO)
+static minitip_THREAD int id_hash[ID_HASH_SIZE];
+static minitip_THREAD int id_hash_used=ID_HASH_SIZE; /* forces a rebuild first */
+
+static int id_hash_slot(const char *var)
+{unsigned h;
+    for(h=2166136261u;*var;var++) h=(h^(unsigned char)*var)*16777619u;
+    return h%ID_HASH_SIZE;
+}
+static void id_hash_add(int i)
+{int h,j;
+    if(2*(id_hash_used+1)>ID_HASH_SIZE){
+        for(h=0;h<ID_HASH_SIZE;h++) id_hash[h]=-1;
+        id_hash_used=0;
+        for(j=0;j<i;j++) id_hash_add(j);
+    }
+    for(h=id_hash_slot(id_table[i].id);id_hash[h]>=0;h=(h+1)%ID_HASH_SIZE);
+    id_hash[h]=i; id_hash_used++;
+}
 
 static int search_id(const char *var)
-{int i;
-    for(i=0;i<id_table_idx;i++){
-        if(strcmp(id_table[i].id,var)==0) return i;
+{int h,i;
+    if(id_table_idx==0) id_hash_used=ID_HASH_SIZE; /* all entries are stale */
+    else for(h=id_hash_slot(var);(i=id_hash[h])>=0;h=(h+1)%ID_HASH_SIZE){
+        if(i<id_table_idx && strcmp(id_table[i].id,var)==0) return i;
     }
     if(id_table_idx>0 && no_new_id_str){
         harderr(no_new_id_str);
@@ -358,38 +587,59 @@ static int search_id(const char *var)
         id_table_idx--;
     } else {
         strncpy(id_table[id_table_idx-1].id,var,minitip_MAX_ID_LENGTH);
+        id_hash_add(id_table_idx-1); id_version++;
     }
     return id_table_idx-1;
 }
 inline static void no_new_id(char *str)
 {   no_new_id_str=str; }
 
+const char *get_idname(int i)
+{   return 0<=i && i<id_table_idx ? id_table[i].id : NULL; }
+
+/* ranks are recomputed when id_version or the number of identifiers
+   has changed; identifiers beyond id_table_idx are printed as "?" and
+   come first, as "?" precedes the names */
+static minitip_THREAD int ranked_version=-1, ranked_n=-1;
+static minitip_THREAD int id_order[32];	/* identifiers in alphabetical order */
+static minitip_THREAD unsigned rank_map[4][256]; /* rank bitmap of each byte of v */
+
+static void rank_ids(void)
+{int i,j,k,b,u; unsigned bit[32];
+    if(ranked_version==id_version && ranked_n==id_table_idx) return;
+    u=32-id_table_idx; /* number of unknown identifiers */
+    for(i=0;i<u;i++) id_order[i]=id_table_idx+i;
+    for(i=0;i<id_table_idx;i++){ /* insertion sort */
+        for(j=u+i;j>u && strcmp(id_table[id_order[j-1]].id,id_table[i].id)>0;j--)
+            id_order[j]=id_order[j-1];
+        id_order[j]=i;
+    }
+    for(i=0;i<32;i++) bit[id_order[i]]=1u<<(31-i);
+    for(k=0;k<4;k++) for(b=0;b<256;b++){
+        rank_map[k][b]=0;
+        for(j=0;j<8;j++) if(b&(1<<j)) rank_map[k][b] |= bit[8*k+j];
+    }
+    ranked_version=id_version; ranked_n=id_table_idx;
+}
+inline static unsigned rank_bits(int v)
+{   return rank_map[0][v&255] | rank_map[1][(v>>8)&255] |
+           rank_map[2][(v>>16)&255] | rank_map[3][((unsigned)v>>24)&255];
+}
+
 #define MAX_REPR_LENGTH 201	/* longer list is not understandable; >= 26 */
 static char *get_idlist_repr(int v, int slotno)
-{static char slot1[MAX_REPR_LENGTH+2], slot2[MAX_REPR_LENGTH+2];
-const char *unsorted[minitip_MAX_ID_NO+1];
- char *slot; const char *var; int i,j,n;
-    for(i=0,n=0;v!=0;i++,v>>=1)if(v&1){
-        unsorted[n]=i<id_table_idx ? id_table[i].id : "?"; 
-        n++;
-    }
-    j=1; // sort the variables
-    while(j){
-        j=0;
-        for(i=0;i<n-1;i++){
-            if(strcmp(unsorted[i],unsorted[i+1])>0 ){
-                var=unsorted[i]; unsorted[i]=unsorted[i+1]; unsorted[i+1]=var;
-                j=1;         
-            }
-        }
-    }
+{static minitip_THREAD char slot1[MAX_REPR_LENGTH+2], slot2[MAX_REPR_LENGTH+2];
+ char *slot; const char *var; int i,j,r;
+    rank_ids();
     slot= slotno==1 ? slot1 : slot2;
-    for(i=0,j=0;i<n;i++){
+    for(r=0,j=0;r<32;r++){
+        i=id_order[r];
+        if((((unsigned)v>>i)&1)==0) continue;
         if(j>0 && X_style==ORIGINAL){ 
             slot[j]=','; /* comma separated */
             if(j<MAX_REPR_LENGTH) j++;
         }
-        for(var=unsorted[i];*var;var++){
+        for(var= i<id_table_idx ? id_table[i].id : "?";*var;var++){
             slot[j]=*var;
             if(j<MAX_REPR_LENGTH)j++;
         }
@@ -397,6 +647,62 @@ const char *unsorted[minitip_MAX_ID_NO+1];
     slot[j]=0; return slot;
 }
 
+/***********************************************************************
+* Parser state
+*   The macro table, the identifier table and the style settings. The
+*   module works on the state in the static variables above; a saved
+*   state is exchanged with them by parser_state_swap().
+*/
+struct parser_state_t {
+    syntax_style_t style; char sep; int xvar, msr;
+    int max_macros, standard_macros, macro_total;
+    struct macro_text_t *macro_text;
+    struct macro_block_t *macro_arena; int arena_live, arena_waste;
+    struct macro_key_t *macro_index; int index_size, index_used;
+    int id_table_idx;
+    char id_table[minitip_MAX_ID_NO+1][minitip_MAX_ID_LENGTH+1];
+    int id_hash[ID_HASH_SIZE], id_hash_used;
+};
+
+static void swap_mem(void *a, void *b, size_t n)
+{unsigned char *p=a,*q=b,t;
+    while(n--){ t=*p; *p++=*q; *q++=t; }
+}
+#define swap_var(x,y)	swap_mem(&(x),&(y),sizeof(x))
+
+struct parser_state_t *parser_state_new(void)
+{struct parser_state_t *s;
+    s=calloc(1,sizeof(struct parser_state_t));
+    if(s) s->id_hash_used=ID_HASH_SIZE; /* empty, rebuilt first */
+    return s;
+}
+
+void parser_state_swap(struct parser_state_t *s)
+{   swap_var(X_style,s->style); swap_var(X_sep,s->sep);
+    swap_var(X_xvar,s->xvar); swap_var(X_msr,s->msr);
+    swap_var(max_macros,s->max_macros);
+    swap_var(standard_macros,s->standard_macros);
+    swap_var(macro_total,s->macro_total);
+    swap_var(macro_text,s->macro_text);
+    swap_var(macro_arena,s->macro_arena);
+    swap_var(arena_live,s->arena_live); swap_var(arena_waste,s->arena_waste);
+    swap_var(macro_index,s->macro_index);
+    swap_var(index_size,s->index_size); swap_var(index_used,s->index_used);
+    swap_var(id_table_idx,s->id_table_idx);
+    swap_mem(id_table,s->id_table,sizeof(s->id_table));
+    swap_mem(id_hash,s->id_hash,sizeof(s->id_hash));
+    swap_var(id_hash_used,s->id_hash_used);
+    id_version++;
+}
+
+void parser_state_free(struct parser_state_t *s)
+{   if(!s) return;
+    free_arena(s->macro_arena);
+    if(s->macro_index) free(s->macro_index);
+    if(s->macro_text) free(s->macro_text);
+    free(s);
+}
+
 /***********************************************************************
 * A parsed item is put into the ITEM structure. It is either en entropy
 *     expression or a macro invocation. Then it is converted into the
@@ -431,7 +737,7 @@ typedef struct {	/* item structure */
   int		var1, var2, var3, var4;
 } ITEM;
 
-static ITEM item;
+static minitip_THREAD ITEM item;
 
 /***********************************************************************
 * struct entropy_expr_t entropy_expr
@@ -442,28 +748,103 @@ static ITEM item;
 *   The convenience macros ee_n, ee_item, ee_type are defined to denote
 *   fields of the entropy_expr structure in this section.
 */
-struct entropy_expr_t entropy_expr;
+minitip_THREAD struct entropy_expr_t entropy_expr;
 
 #define ee_n	entropy_expr.n
 #define ee_item	entropy_expr.item
 #define ee_type entropy_expr.type
 
 /***********************************************************************
+* int ee_room(int n)
+*    make room for n items in entropy_expr; return 0 if out of memory.
 * int ee_varidx(var)
 *    find the variable list in entropy_expr, or add a new 
 *    entry if not found.
+*
+*  The items are found through the ee_hash[] table. An entry holds
+*  the index of an item and is valid when gen equals ee_gen and the
+*  item has the same variable list; clearing the expression increases
+*  ee_gen. The first ee_hashed items are in the table; when this is
+*  not ee_n, the items were rearranged, and the table is rebuilt.
 */
+static minitip_THREAD int ee_max=0;	/* size of the item array */
+static minitip_THREAD struct { int idx; unsigned gen; } *ee_hash=NULL;
+static minitip_THREAD int ee_hash_size=0;	/* a power of 2 */
+static minitip_THREAD unsigned ee_gen=1;	/* current generation */
+static minitip_THREAD int ee_hashed=0;	/* items in the hash table */
+
+static int ee_room(int n)
+{struct entropy_item_t *item;
+    if(n<=ee_max) return 1;
+    if(n<2*ee_max) n=2*ee_max;
+    if(n<64) n=64;
+    item=realloc(ee_item,n*sizeof(struct entropy_item_t));
+    if(item==NULL) return 0;
+    ee_item=item; ee_max=n;
+    return 1;
+}
+
+static int ee_hash_slot(int var)
+{unsigned h;
+    h=(unsigned)var*0x9E3779B1u;
+    return (h^(h>>16))&(ee_hash_size-1);
+}
+
+static void ee_new_gen(void)
+{int h;
+    if(++ee_gen==0){ /* wrapped around */
+        for(h=0;h<ee_hash_size;h++) ee_hash[h].gen=0;
+        ee_gen=1;
+    }
+    ee_hashed=0;
+}
+
+static void ee_hash_add(int i)
+{int h;
+    for(h=ee_hash_slot(ee_item[i].var);ee_hash[h].gen==ee_gen;h=(h+1)&(ee_hash_size-1));
+    ee_hash[h].idx=i; ee_hash[h].gen=ee_gen;
+}
+
+/* make the hash table valid for ee_n+1 items; 0 if out of memory */
+static int ee_rehash(void)
+{int size,i;
+    if(ee_hashed==ee_n && 2*(ee_n+1)<=ee_hash_size) return 1;
+    if(2*(ee_n+1)>ee_hash_size){
+        for(size=256;size<4*(ee_n+1);size<<=1);
+        free(ee_hash);
+        ee_hash=calloc(size,sizeof(*ee_hash));
+        if(ee_hash==NULL){ ee_hash_size=0; return 0; }
+        ee_hash_size=size; ee_gen=0;
+    }
+    ee_new_gen();
+    for(i=0;i<ee_n;i++) ee_hash_add(i);
+    ee_hashed=ee_n;
+    return 1;
+}
+
 static int ee_varidx(int var)
-{int i;
-    for(i=0;i<ee_n;i++) if(var==ee_item[i].var) return i;
-    ee_n++; // i==ee_n
-    if(ee_n>=minitip_MAX_EXPR_LENGTH){
+{int h,i;
+    if(!ee_rehash() || !ee_room(ee_n+1)){
         softerr(e_TOO_LONG_EXPR);
-        ee_n--; i--;
+        return -1;
     }
+    for(h=ee_hash_slot(var);ee_hash[h].gen==ee_gen;h=(h+1)&(ee_hash_size-1)){
+        i=ee_hash[h].idx;
+        if(ee_item[i].var==var) return i;
+    }
+    i=ee_n; ee_n++;
     ee_item[i].var=var; ee_item[i].coeff=0.0;
+    ee_hash[h].idx=i; ee_hash[h].gen=ee_gen; ee_hashed=ee_n;
     return i;
 }
+
+/* release the expression buffers of the calling thread */
+void parser_release_buffers(void)
+{   if(ee_item) free(ee_item);
+    ee_item=NULL; ee_n=0; ee_max=0;
+    if(ee_hash) free(ee_hash);
+    ee_hash=NULL; ee_hash_size=0; ee_hashed=0;
+}
 /***********************************************************************
 * increase / decrease the coefficient of a variable or a certain 
 *    entropy expression by a given value d
@@ -472,10 +853,11 @@ static int ee_varidx(int var)
 *  ee_i2(var1,var2,d)      add d* I(var1;var2)
 *  ee_i3(var1,va2,var3,d)  add d*I(var1;var2|var3)
 */
-#define ee_add(v,d)	\
-    ee_item[ee_varidx(v)].coeff += (d)
-#define ee_subtr(v,d)	\
-    ee_item[ee_varidx(v)].coeff -= (d)
+static void ee_add(int v,double d)
+{int i;
+    if((i=ee_varidx(v))>=0) ee_item[i].coeff += d;
+}
+#define ee_subtr(v,d)	ee_add(v,-(d))
 inline static void ee_i2(int v1,int v2,double d){
     ee_add(v1,d); ee_add(v2,d); ee_subtr(v1|v2,d);
 }
@@ -498,13 +880,13 @@ inline static void ee_i3(int v1,int v2,int v3, double d){
 *    given the item stored in ITEM, add it to the entropy expression
 *    in entropy_expr. Constraints are handled separately
 */
-static double ee_multiplier;
+static minitip_THREAD double ee_multiplier;
 
 inline static void clear_entexpr(void)
-{ee_multiplier=1.0; ee_n=0;}
+{ee_multiplier=1.0; ee_n=0; ee_new_gen();}
 
 static void convert_item_to_expr(void)
-{double d; int j; struct entropy_expr_t *M;
+{double d; int j; struct macro_text_t *M;
     if(syntax_error.softerrstr || syntax_error.harderrstr) return;
     d=item.multiplier*ee_multiplier;
     switch(item.item_type){
@@ -535,22 +917,24 @@ static void convert_item_to_expr(void)
        ee_i2(item.var3,item.var4,d);
        break;
   case Macro:   /* M(ab,bc,cd) */
-       M = macro_text[item.var1].expr;
+       M = &macro_text[item.var1];
        for(j=0;j<M->n;j++){
            ee_add(var_merge(M->item[j].var,item.vars),d*M->item[j].coeff);
        }
        break;
   case Func:	/* v1 : v2 */
+      if(!ee_room(2)){ softerr(e_TOO_LONG_EXPR); break; }
       ee_type=ent_eq;
-      ee_n=2;
+      ee_n=2; ee_hashed=-1;
       ee_item[0].var=item.var1;
       ee_item[1].var=item.var2;
       ee_item[0].coeff=+1.0;
       ee_item[1].coeff=-1.0;
       break;
   case Indep:	/* v1 || v2 */
+      if(!ee_room(2)){ softerr(e_TOO_LONG_EXPR); break; }
       ee_type=ent_eq;
-      ee_n=2;
+      ee_n=2; ee_hashed=-1;
       ee_item[0].var=item.var1;
       ee_item[1].var=item.var2;
       ee_item[0].coeff=+1.0;
@@ -558,9 +942,10 @@ static void convert_item_to_expr(void)
       break;
   case Markov:  /* v1 -> */
       ee_type=ent_Markov;
+      if(!ee_room(ee_n+1)){ softerr(e_TOO_LONG_EXPR); break; }
       ee_item[ee_n].var=item.var1;
       ee_item[ee_n].coeff=+1.0;
-      ee_n++;
+      ee_n++; ee_hashed=-1;
       break;
   default:
       must(0,e_INTERNAL);
@@ -582,7 +967,7 @@ static void collapse_expr(void)
            ee_item[j].coeff=0.0;
         }
     }
-    ee_n=i;
+    ee_n=i; ee_hashed=-1;
 }
 
 /***********************************************************************
@@ -614,7 +999,7 @@ static int first_variable_not_used(void)
 * void print_expression(void)
 *    print out the expression collected in 'entropy_expr' using the
 *    actual style. Sort variable lists first by their length, next
-*    alphanumerically by their printout representation.
+*    alphabetically by the sorted names of the variables.
 *
 * void print_macro_with_idx(int idx)
 *    print out the macro at slot idx
@@ -626,67 +1011,86 @@ static int first_variable_not_used(void)
 *    returns the number of bits set in v.
 *
 * void sort_expr_by_variables(void)
-*    using bubble sort to reshuffle the expression terms.
+*    sort the expression terms by the key (bitno, rank_bits).
+*
+* Output is collected in out_buf[] and written to out_to when full
+*  void out_start(FILE *to)   start writing to the stream
+*  void out_str(const char *s), out_char(char c)
+*                             add a string or a character
+*  void out_coeff(double d)   add a coefficient with its sign; 1 and
+*                             -1 are written as the sign only
+*  void out_flush(void)       write out the collected text
 */
 inline static int bitno(int v)
 {int i;
-    for(i=0;v;v>>=1){
-        if(v&1)i++;
-    }
+    for(i=0;v;v&=v-1) i++;
     return i;
 }
-/* use bubble sort to sort the expression in ee_item by variables */
+static int cmp_by_variables(const void *a, const void *b)
+{int v1,v2,n1,n2; unsigned r1,r2;
+    v1=((const struct entropy_item_t*)a)->var;
+    v2=((const struct entropy_item_t*)b)->var;
+    n1=bitno(v1); n2=bitno(v2);
+    if(n1!=n2) return n1<n2 ? -1 : 1;
+    r1=rank_bits(v1); r2=rank_bits(v2);
+    return r1>r2 ? -1 : r1<r2 ? 1 : 0;
+}
 static void sort_expr_by_variables(void)
-{int i,working; int v1,v2; double cf;
-    working=1;
-    while(working){
-        working=0;
-        for(i=0;i<ee_n-1;i++){
-            v1=ee_item[i].var; v2=ee_item[i+1].var;
-            if(bitno(v1)>bitno(v2) ||
-               (bitno(v1)==bitno(v2) &&
-                  strcmp(get_idlist_repr(v1,1),get_idlist_repr(v2,2))>0) ){
-                working=1;
-                ee_item[i].var=v2; ee_item[i+1].var=v1;
-                cf=ee_item[i].coeff; ee_item[i].coeff=ee_item[i+1].coeff; ee_item[i+1].coeff=cf;
-            }
-        }
-    }
+{   rank_ids(); ee_hashed=-1;
+    qsort(ee_item,ee_n,sizeof(struct entropy_item_t),cmp_by_variables);
 }
-/* dump the expression in ee_item */
-static void dump_expression(FILE *to)
-{int i; double d;
-    if(ee_n<=0){ printf("0"); return; }
-    sort_expr_by_variables();
+
+static minitip_THREAD char out_buf[4096];
+static minitip_THREAD int out_len=0;
+static minitip_THREAD FILE *out_to=NULL;
+
+static void out_start(FILE *to)
+{   out_to=to; out_len=0; }
+static void out_flush(void)
+{   if(out_len>0) fwrite(out_buf,1,out_len,out_to);
+    out_len=0;
+}
+static void out_str(const char *s)
+{int n;
+    n=strlen(s);
+    if(out_len+n>(int)sizeof(out_buf)) out_flush();
+    if(n>(int)sizeof(out_buf)){ fwrite(s,1,n,out_to); return; }
+    memcpy(out_buf+out_len,s,n); out_len+=n;
+}
+static void out_char(char c)
+{   if(out_len>=(int)sizeof(out_buf)) out_flush();
+    out_buf[out_len++]=c;
+}
+static void out_coeff(double d)
+{char buf[40];
+    if(d<1.0+1e-9 && d>1.0-1e-9){ out_char('+'); }
+    else if(d<-1.0+1e-9 && d>-1.0-1e-9){ out_char('-'); }
+    else { snprintf(buf,sizeof(buf),"%+lg",d); out_str(buf); }
+}
+
+/* write the expression in ee_item to the stream */
+static void write_expression(FILE *to)
+{int i;
+    out_start(to);
+    if(ee_n<=0) out_char('0');
+    else sort_expr_by_variables();
     for(i=0;i<ee_n;i++){
-        d=ee_item[i].coeff;
-        if(d<1.0+1e-9 && d>1.0-1e-9){ fprintf(to,"+"); }
-        else if(d<-1.0+1e-9 && d>-1.0-1e-9){ fprintf(to,"-"); }
-        else {fprintf(to,"%+lg",d); }
+        out_coeff(ee_item[i].coeff);
         if(X_style==ORIGINAL){
-            fprintf(to,"H(%s)",get_idlist_repr(ee_item[i].var,1));
+            out_str("H("); out_str(get_idlist_repr(ee_item[i].var,1));
+            out_char(')');
         } else {
-            fprintf(to,"%s",get_idlist_repr(ee_item[i].var,1));
+            out_str(get_idlist_repr(ee_item[i].var,1));
         }
     }
+    out_flush();
 }
+/* dump the expression in ee_item */
+static void dump_expression(FILE *to)
+{   write_expression(to); }
 /* print out the expression in ee_item */
 void print_expression(void)
-{int i; double d;
-    if(ee_n<=0){ printf("0"); return; }
-    sort_expr_by_variables();
-    for(i=0;i<ee_n;i++){
-        d=ee_item[i].coeff;
-        if(d<1.0+1e-9 && d>1.0-1e-9){ printf("+"); }
-        else if(d<-1.0+1e-9 && d>-1.0-1e-9){ printf("-"); }
-        else {printf("%+lg",d); }
-        if(X_style==ORIGINAL){
-            printf("H(%s)",get_idlist_repr(ee_item[i].var,1));
-        } else {
-            printf("%s",get_idlist_repr(ee_item[i].var,1));
-        }
-    }
-}
+{   write_expression(stdout); }
 /* print expression in natural coordinates: assume exactly
    four variables are used */
 static void print_natcoord(int idx)
@@ -703,106 +1107,121 @@ static void print_natcoord(int idx)
           case 'c': var |=4; break;
           case 'd': var |=8; break;
           case 'I': case 'H':
-                    if(X_style==ORIGINAL) printf("%c",*v);
+                    if(X_style==ORIGINAL) out_char(*v);
                     break;
           default:
-             if(var){printf("%s",get_idlist_repr(var,1)); var=0;}
-             printf("%c",*v!=','?*v : X_style==ORIGINAL ? ';': X_sep);
+             if(var){out_str(get_idlist_repr(var,1)); var=0;}
+             out_char(*v!=','?*v : X_style==ORIGINAL ? ';': X_sep);
         }
     }
 }
-/* print the expression stored in ee_item[] in natural coordinates */
+/***********************************************************************
+* I-measure atoms
+*   The atom of the nonempty subset i of the n variables is the mutual
+*   information of the variables in i conditioned on the others; H(v)
+*   is the sum of the atoms meeting v. The coefficient of atom i in the
+*   expression is thus total-g(~i), where g(s) is the sum of the
+*   coefficients of the terms inside s, the subset sum (zeta transform)
+*   of the coefficients.
+*
+* void zeta_transform(double f[], int n)
+*   f[s] becomes the sum of f[t] for all t subset of s; O(n*2^n)
+* void measure_atoms(double m[], int n)
+*   m[0..2^n-1] is set to the atom coefficients of the expression in
+*   ee_item[]; terms with other variables are skipped.
+* int next_subset(int i)
+*   the next integer with the same number of bits set
+*
+* ext uses the transform up to MEASURE_DENSE_MAX variables, where the
+* array has 8 MB; above that the atoms are summed one by one.
+*/
+#define MEASURE_DENSE_MAX	20
+static void zeta_transform(double f[], int n)
+{int h,i,j,size;
+    size=1<<n;
+    for(h=1;h<size;h<<=1) for(i=0;i<size;i+=2*h)
+        for(j=i;j<i+h;j++) f[j+h]+=f[j];
+}
+static void measure_atoms(double m[], int n)
+{int i,mask; double total,t;
+    mask=(1<<n)-1;
+    for(i=0;i<=mask;i++) m[i]=0.0;
+    for(total=0.0,i=0;i<ee_n;i++){
+        if(ee_item[i].var & ~mask) continue;
+        m[ee_item[i].var]+=ee_item[i].coeff; total+=ee_item[i].coeff;
+    }
+    zeta_transform(m,n);
+    for(i=0;i<=mask;i++) if(i<(mask^i)){
+        t=m[i]; m[i]=total-m[mask^i]; m[mask^i]=total-t;
+    }
+}
+inline static int next_subset(int i)
+{unsigned c,r;
+    c=i&-i; r=i+c;
+    return (int)((((r^i)>>2)/c)|r);
+}
+/* print the expression stored in ee_item[] in natural coordinates;
+   the coordinates in natcoords[] order are computed from the atoms */
 void print_in_natural_coords(void)
-{static int invnat[]={
-  -2, 1, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1, 0, 0, 0, // a     1 
-  -2, 1, 1, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 0, 0, // b     2
-  -3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 0, 0, // ab    3
-  -2, 0, 1, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, // c     4
-  -3, 1, 1, 1, 1, 1, 0, 2, 1, 1, 2, 1, 0, 1, 0, // ac    5
-  -3, 1, 1, 1, 1, 0, 1, 1, 2, 1, 2, 0, 1, 1, 0, // bc    6
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 3, 1, 1, 1, 0, // abc   7
-  -2, 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, // d     8
-  -3, 1, 1, 1, 0, 1, 1, 2, 1, 1, 2, 1, 0, 0, 1, // ad    9
-  -3, 1, 1, 0, 1, 1, 1, 1, 2, 1, 2, 0, 1, 0, 1, // bd   10 
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 3, 1, 1, 0, 1, // abd  11
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 2, 0, 0, 1, 1, // cd   12
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 3, 1, 0, 1, 1, // acd  13
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 3, 0, 1, 1, 1, // bcd  14
-  -4, 1, 1, 1, 1, 1, 1, 2, 2, 1, 3, 1, 1, 1, 1, // abcd 15
-  }; double d; int i,j;
+{double m[16],lambda[15],A,B,C,D; int i;
    if(ee_n<=0){ printf("0"); return; }
+   measure_atoms(m,4);
+   lambda[1]=m[11]; lambda[2]=m[7];  lambda[3]=m[5];  lambda[4]=m[6];
+   lambda[5]=m[9];  lambda[6]=m[10]; lambda[9]=m[15];
+   lambda[11]=m[1]; lambda[12]=m[2]; lambda[13]=m[4]; lambda[14]=m[8];
+   A=m[13]-m[5]-m[9]-m[15]; B=m[14]-m[6]-m[10]-m[15];
+   C=m[12]-m[15]; D=m[3]-m[7]-m[11];
+   lambda[0]=A+B-C; lambda[7]=C-A; lambda[8]=C-B; lambda[10]=D-lambda[0];
+   out_start(stdout);
    for(i=0;i<15;i++){
-       d=0.0; // use column i from invnat[]
-       for(j=0;j<ee_n;j++)
-          if(1<=ee_item[j].var && ee_item[j].var<=15){
-             d+= ee_item[j].coeff*invnat[i+(ee_item[j].var-1)*15];
-       }
-       if(d<1e-9 && d>-1e-9) continue;
-       if(d<1.0+1e-9 && d>1.0-1e-9){ printf("+"); }
-       else if(d<-1.0+1e-9 && d>-1.0-1e-9){ printf("-"); }
-       else {printf("%+lg",d); }
+       if(lambda[i]<1e-9 && lambda[i]>-1e-9) continue;
+       out_coeff(lambda[i]);
        print_natcoord(i);
    }
+   out_flush();
 }
 /* print information measure; idx < (1<<id_table_idx) */
 static void print_mscoord(int idx)
-{int i,j,cnt; const char *unsorted[minitip_MAX_ID_NO+1];
+{int i,r,cnt;
    if(idx==0) return;
-   if(X_style==ORIGINAL){ // figure out if H() or I()
-      cnt=0;
-      for(i=idx;i>0;i>>=1){ if(i&1) cnt++; }
-      printf("%c",cnt==1?'H':'I');
-   }
-   printf("("); cnt=0;
-   for(i=0;i<id_table_idx;i++) if(idx &(1<<i)){
-      unsorted[cnt]=id_table[i].id;
-      cnt++;
-   }
-   j=1; // sort the variables
-   while(j){
-      j=0;
-      for(i=0;i<cnt-1;i++){
-         if(strcmp(unsorted[i],unsorted[i+1])>0){
-            const char *var=unsorted[i];unsorted[i]=unsorted[i+1];
-            unsorted[i+1]=var; j=1;
-         }
-      }
-   }
-   for(i=0;i<cnt;i++){
-       if(i>0){printf("%c",X_style==ORIGINAL ? ';':X_sep);}
-       printf("%s",unsorted[i]);
+   cnt=bitno(idx);
+   if(X_style==ORIGINAL) out_char(cnt==1?'H':'I'); // H() or I()
+   out_char('('); rank_ids();
+   for(r=32-id_table_idx,i=0;r<32;r++) if(idx&(1<<id_order[r])){
+       if(i>0) out_char(X_style==ORIGINAL ? ';':X_sep);
+       out_str(id_table[id_order[r]].id); i++;
    }
    if(cnt<id_table_idx){
-      printf("|%s",get_idlist_repr(-1+(1<<id_table_idx)-idx,1));
+      out_char('|'); out_str(get_idlist_repr(-1+(1<<id_table_idx)-idx,1));
    }
-   printf(")");
+   out_char(')');
 }
-/* print the expression stored in ee_item[] in measures */
+/* print the expression stored in ee_item[] in measures, ordered by
+   the size of the atoms. With more than MEASURE_DENSE_MAX variables,
+   or if there is no memory for the atoms, they are computed one by
+   one. */
 void print_in_measures(void)
-{int w,ww,i,ii,j,mask; double d;
+{int w,i,j,n,mask; double d,*m;
    if(ee_n<=0){ printf("0"); return; }
-   mask=-1+(1<<id_table_idx);
-   // go over subsets by Hamming weight
-   for(w=1;w<=id_table_idx;w++){
-    for(i=1;i<=mask;i++){ // skip if weight is not w
-      for(ww=0,ii=i;ii;ii>>=1){if(ii&1)ww++; }
-      if(w!=ww) continue;
-      d=0.0;
-      for(j=0;j<ee_n;j++)
-         if(i&ee_item[j].var){
-            d+=ee_item[j].coeff;
-      }
+   n=id_table_idx; mask=-1+(1<<n);
+   m= n<=MEASURE_DENSE_MAX ? malloc((mask+1)*sizeof(double)) : NULL;
+   if(m) measure_atoms(m,n);
+   out_start(stdout);
+   for(w=1;w<=n;w++){
+    for(i=(1<<w)-1;i<=mask;i=next_subset(i)){
+      if(m) d=m[i];
+      else for(d=0.0,j=0;j<ee_n;j++) if(i&ee_item[j].var) d+=ee_item[j].coeff;
       if(d<1e-9 && d>-1e-9) continue;
-      if(d<1.0+1e-9 && d>1.0-1e-9){ printf("+"); }
-      else if(d<-1.0+1e-9 && d>-1.0-1e-9){ printf("-"); }
-      else {printf("%+lg",d); }
+      out_coeff(d);
       print_mscoord(i);
     }
    }
+   out_flush();
+   if(m) free(m);
 }
 /* dump a macro */
 void dump_macro_with_idx(FILE *to, int idx)
-{int i,v; int septype,varno; char varstr[2];
+{int v; int septype,varno; char varstr[2];
     septype=macro_text[idx].head.septype;
     varno=macro_text[idx].head.argno;
     no_new_id(NULL);
@@ -816,16 +1235,15 @@ void dump_macro_with_idx(FILE *to, int idx)
         septype>>=1;
     }
     fprintf(to," = ");
-    entropy_expr.n=macro_text[idx].expr->n;
-    for(i=0;i<entropy_expr.n;i++){
-       entropy_expr.item[i]=macro_text[idx].expr->item[i];
-    }
+    entropy_expr.n=ee_room(macro_text[idx].n) ? macro_text[idx].n : 0;
+    memcpy(entropy_expr.item,macro_text[idx].item,
+           entropy_expr.n*sizeof(struct entropy_item_t));
     dump_expression(to);
     fprintf(to,"\n");
 }
 /* print out a macro */
 void print_macro_with_idx(int idx)
-{int i,v; int septype,varno; char varstr[2];
+{int v; int septype,varno; char varstr[2];
     septype=macro_text[idx].head.septype;
     varno=macro_text[idx].head.argno;
     no_new_id(NULL);
@@ -839,10 +1257,9 @@ void print_macro_with_idx(int idx)
         septype>>=1;
     }
     printf(" = ");
-    entropy_expr.n=macro_text[idx].expr->n;
-    for(i=0;i<entropy_expr.n;i++){
-       entropy_expr.item[i]=macro_text[idx].expr->item[i];
-    }
+    entropy_expr.n=ee_room(macro_text[idx].n) ? macro_text[idx].n : 0;
+    memcpy(entropy_expr.item,macro_text[idx].item,
+           entropy_expr.n*sizeof(struct entropy_item_t));
     print_expression();
     printf("\n");
 }    
@@ -1450,6 +1867,97 @@ int parse_constraint(const char *str, int keep)
     return (syntax_error.softerrstr|| syntax_error.harderrstr) ? PARSE_ERR : PARSE_OK;
 }
 
+/***********************************************************************
+* Compiled constraints
+*
+* int constr_add(struct constraint_t *c, int from, int var, double d)
+*    add d to the coefficient of var in the column whose terms start
+*    at item[from]; c->n is the next free item.
+*
+* struct constraint_t *compile_constraint(void)
+*    compile the constraint in entropy_expr. Memory is allocated in a
+*    single chunk. A Markov chain v0 -> v1 -> ... -> v(k-1) is expanded
+*    into the k-2 columns (v0..vi,v(i+2)..v(k-1)|v(i+1))=0.
+*
+* void free_constraint(struct constraint_t *c)
+*    release the compiled constraint
+*
+* int bind_constraint(struct constraint_t *c, int keep)
+*    register the variable names in id_table[], and fill gvar.
+*/
+static void constr_add(struct constraint_t *c, int from, int var, double d)
+{int i;
+    for(i=from;i<c->n;i++) if(c->item[i].var==var){
+        c->item[i].coeff += d; return;
+    }
+    c->item[i].var=var; c->item[i].gvar=0; c->item[i].coeff=d;
+    c->n++;
+}
+
+struct constraint_t *compile_constraint(void)
+{struct constraint_t *c; int cols,n,i,j,k; char *mem;
+    if(entropy_expr.type==ent_Markov){
+        cols=entropy_expr.n-2; n=4*cols;
+    } else {
+        cols=1; n=entropy_expr.n;
+    }
+    mem=malloc(sizeof(struct constraint_t)+n*sizeof(*c->item)+
+               cols*sizeof(*c->col)+id_table_idx*sizeof(*c->id));
+    if(mem==NULL) return NULL;
+    c=(struct constraint_t *)mem;     mem += sizeof(struct constraint_t);
+    c->item=(void*)mem;               mem += n*sizeof(*c->item);
+    c->col=(void*)mem;                mem += cols*sizeof(*c->col);
+    c->id=(void*)mem;
+    c->idno=id_table_idx;
+    for(i=0;i<id_table_idx;i++) strcpy(c->id[i],id_table[i].id);
+    c->cols=cols; c->n=0;
+    if(entropy_expr.type!=ent_Markov){
+        for(i=0;i<entropy_expr.n;i++){
+            c->item[i].var=entropy_expr.item[i].var; c->item[i].gvar=0;
+            c->item[i].coeff=entropy_expr.item[i].coeff;
+        }
+        c->n=entropy_expr.n;
+        c->col[0].type=entropy_expr.type; c->col[0].from=0; c->col[0].to=c->n;
+        return c;
+    }
+    for(k=0;k<cols;k++){ /* (v1,v2|v)=0 */
+        int v1,v2,v,from;
+        v=v1=v2=0; for(j=0;j<entropy_expr.n;j++){
+            if(j<k+1) v1 |= entropy_expr.item[j].var;
+            else if(j>k+1) v2 |= entropy_expr.item[j].var;
+            else v=entropy_expr.item[j].var;
+        }
+        from=c->n;
+        constr_add(c,from,v1|v,1.0);    constr_add(c,from,v2|v,1.0);
+        constr_add(c,from,v1|v2|v,-1.0);constr_add(c,from,v,-1.0);
+        /* forget zero coefficients */
+        for(i=from,j=from;j<c->n;j++){
+            if(c->item[j].coeff>1.5e-10 || c->item[j].coeff<-1.5e-10){
+                c->item[i]=c->item[j]; i++;
+            }
+        }
+        c->n=i;
+        c->col[k].type=ent_eq; c->col[k].from=from; c->col[k].to=c->n;
+    }
+    return c;
+}
+
+void free_constraint(struct constraint_t *c)
+{   free(c); }
+
+int bind_constraint(struct constraint_t *c, int keep)
+{int tr[minitip_MAX_ID_NO+1]; int i,v,w,j;
+    syntax_error.softerrstr=NULL; syntax_error.harderrstr=NULL;
+    no_new_id(NULL);
+    if(!keep) id_table_idx=0;
+    for(i=0;i<c->idno;i++) tr[i]=1<<search_id(c->id[i]);
+    for(i=0;i<c->n;i++){
+        for(w=0,j=0,v=c->item[i].var;v;j++,v>>=1) if(v&1){ w|=tr[j]; }
+        c->item[i].gvar=w;
+    }
+    return syntax_error.softerrstr ? PARSE_ERR : PARSE_OK;
+}
+
 /***********************************************************************
 * parse a macro definition. It start with the macro name, then comes
 *    the argument list, an '=' sign, and then the macro text.
@@ -1544,6 +2052,37 @@ int parse_macro_definition(const char *str)
     return(syntax_error.softerrstr|| syntax_error.harderrstr)? PARSE_ERR : PARSE_OK;
 }
 
+/***********************************************************************
+* define the standard macros
+*
+* int parse_standard_macros(void)
+*   H(a), H(a|b), I(a,b), I(a,b|c), followed by the additional measures
+*     I(a,b,x)  =I(a,b)-I(a,b|x)
+*     I(a,b,x|y)=I(a,b|y)-I(a,b|xy), etc.
+*   up to minitip_MAX_MEASURE_DEPTH arguments. The style is set to
+*   simple. Returns the slot of the first additional measure, or -1 if
+*   some definition failed.
+*/
+int parse_standard_macros(void)
+{char buff[200],seq[2*minitip_MAX_MEASURE_DEPTH+1];
+ int d,i,measures;
+    set_syntax_style(syntax_short,',',1);
+    if(parse_macro_definition("H(a)=a")!=PARSE_OK) return -1;
+    if(parse_macro_definition("H(a|b)=ab-b")!=PARSE_OK) return -1;
+    if(parse_macro_definition("I(a,b)=a+b-ab")!=PARSE_OK) return -1;
+    if(parse_macro_definition("I(a,b|c)=ac+bc-c-abc")!=PARSE_OK) return -1;
+    measures=macro_total;
+    for(d=3;d<minitip_MAX_MEASURE_DEPTH;d++){
+        for(i=3;i<d;i++){ seq[2*i-6]=','; seq[2*i-5]='a'+i-1; }
+        seq[2*d-6]=0;
+        sprintf(buff,"I(a,b%s,x)=I(a,b%s)-I(a,b%s|x)",seq,seq,seq);
+        if(parse_macro_definition(buff)!=PARSE_OK) return -1;
+        sprintf(buff,"I(a,b%s,x|y)=I(a,b%s|y)-I(a,b%s|xy)",seq,seq,seq);
+        if(parse_macro_definition(buff)!=PARSE_OK) return -1;
+    }
+    return measures;
+}
+
 /***********************************************************************
 * parse a conversion request. It may start with a variable list and slash,
 *   followed by the obligatory expression to be converted.
@@ -70,7 +70,7 @@ struct syntax_error_t {
    int softerrpos, harderrpos;
    int showexpression;
 };
-extern struct syntax_error_t syntax_error;
+extern minitip_THREAD struct syntax_error_t syntax_error;
 
 /***********************************************************************
 * Parsed entropy line
@@ -80,6 +80,8 @@ extern struct syntax_error_t syntax_error;
 *  item -- the items; for each item
 *    item[].var   -- a bitmap of random variables defining a set
 *    item[].coeff -- the coefficient of this entropy term
+*          the item array grows as the expression is parsed; it is
+*          owned by the parser.
 */
 
 typedef enum {  /* type of the constrain/expression */
@@ -90,16 +92,18 @@ typedef enum {  /* type of the constrain/expression */
     ent_mdef,	/* macro definition */
 } expr_type_t;
 
+struct entropy_item_t { /* an entropy term */
+    int var;
+    double coeff;
+};
+
 struct entropy_expr_t { /* the expression itself */
     expr_type_t type; /* type */
     int n;	      /* number of items */
-    struct {
-      int var;
-      double coeff;
-    } item [minitip_MAX_EXPR_LENGTH];
+    struct entropy_item_t *item; /* the items */
 };
 
-extern struct entropy_expr_t entropy_expr;
+extern minitip_THREAD struct entropy_expr_t entropy_expr;
 
 /***********************************************************************
 * int resize_macro_table(int newsize)
@@ -109,7 +113,7 @@ extern struct entropy_expr_t entropy_expr;
 *    H(X), H(X|Y), I(X;Y); I(X;Y|Z)
 */
 int resize_macro_table(int newsize);
-extern int macro_total;
+extern minitip_THREAD int macro_total;
 
 /***********************************************************************
 * Parsing routines
@@ -153,6 +157,68 @@ int parse_constraint(const char *str, int keep);
 int parse_macro_definition(const char *str);
 int parse_conv(const char *str, int maxvar);
 
+/***********************************************************************
+* int parse_standard_macros(void)
+*    define the standard macros H(a), H(a|b), I(a,b), I(a,b|c) and the
+*    additional measures I(a,b,x), I(a,b,x|y), ... in an empty macro
+*    table. Returns the slot of the first additional measure, or -1 if
+*    there is no space for them.
+*/
+int parse_standard_macros(void);
+
+/***********************************************************************
+* Compiled constraints
+*    A constraint is parsed only once when added, and stored in the
+*    compiled form below. Random variables are numbered locally; their
+*    names are kept so that they can be bound to the variables of the
+*    expression to be checked. Markov chains are expanded into their
+*    (v1,v2|v)=0 equalities. Each column is a linear combination of
+*    entropy terms which is either =0 or >=0.
+*  idno    -- number of random variables in the constraint
+*  id[]    -- their names; bit i of a local bitmap stands for id[i]
+*  cols    -- number of columns
+*  col[]   -- col[i].type is ent_eq or ent_ge, its terms are
+*             item[col[i].from] ... item[col[i].to-1]
+*  n       -- total number of terms
+*  item[]  -- entropy terms; var is a local bitmap, gvar is var
+*             translated by bind_constraint()
+*
+* struct constraint_t *compile_constraint(void)
+*    compile the constraint which has just been parsed successfully by
+*    parse_constraint(). Return NULL if out of memory.
+* void free_constraint(struct constraint_t *c)
+*    release the memory allocated for the compiled constraint.
+* int bind_constraint(struct constraint_t *c, int keep)
+*    add the variables of the constraint to the identifier table
+*    (clear it first if keep==0), and fill the gvar fields. Return
+*    PARSE_OK, or PARSE_ERR if there are too many variables.
+*/
+struct constraint_t {
+    int idno;			/* number of variables */
+    char (*id)[minitip_MAX_ID_LENGTH+1]; /* variable names */
+    int cols;			/* number of columns */
+    struct {
+      expr_type_t type;		/* ent_eq or ent_ge */
+      int from, to;		/* item range */
+    } *col;
+    int n;			/* number of terms */
+    struct {
+      int var, gvar;		/* local and bound bitmap */
+      double coeff;		/* coefficient */
+    } *item;
+};
+
+struct constraint_t *compile_constraint(void);
+void free_constraint(struct constraint_t *c);
+int bind_constraint(struct constraint_t *c, int keep);
+
+/***********************************************************************
+* const char *get_idname(int i)
+*    the name of the random variable which is bit i in the var fields
+*    of entropy_expr, or NULL if there is no such variable.
+*/
+const char *get_idname(int i);
+
 /***********************************************************************
 * Delete a macro
 *  int parse_delete_macro(char *str)
@@ -165,6 +231,27 @@ int parse_conv(const char *str, int maxvar);
 int parse_delete_macro(const char *str);
 void delete_macro_with_idx(int idx);
 
+/***********************************************************************
+* Parser state
+*    The macro table, the identifier table and the syntax style form
+*    the state of the parser. The parser works on one state at a time in
+*    each thread; others can be saved and exchanged with it.
+*  struct parser_state_t *parser_state_new(void)
+*    a new state with no macros, no identifiers and the initial style.
+*    Returns NULL if out of memory.
+*  void parser_state_swap(struct parser_state_t *s)
+*    exchange the state of the parser with s.
+*  void parser_state_free(struct parser_state_t *s)
+*    release a saved state together with its macros.
+*  void parser_release_buffers(void)
+*    release the buffers of entropy_expr in the calling thread.
+*/
+struct parser_state_t;
+struct parser_state_t *parser_state_new(void);
+void parser_state_swap(struct parser_state_t *s);
+void parser_state_free(struct parser_state_t *s);
+void parser_release_buffers(void);
+
 /***********************************************************************
 * Printing in raw format
 *    These routines print a linear combination of entropies.
@@ -0,0 +1,388 @@
+/* simplex.c: built-in simplex method for the Shannon LP */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "minitip.h"
+#include "simplex.h"
+
+#define EPS_PIVOT	1e-9	/* smallest pivot element */
+#define EPS_COST	1e-9	/* reduced cost tolerance */
+#define EPS_FEAS	1e-7	/* phase 1 objective taken as zero */
+#define DEGENERATE	50	/* degenerate steps before Bland's rule */
+#define PERTURB		1e-6	/* relative perturbation of the goal */
+
+minitip_THREAD int splx_iterations;
+
+/*----------------------------------------------------------------*/
+/* variables of the LP */
+#define V_ART		0	/* artificial variable of row a */
+#define V_MONO		1	/* N-a <= N */
+#define V_ELEM		2	/* (a,b|K) >= 0 */
+#define V_CONSTR	3	/* constraint column a with sign b */
+
+struct var_t { int kind,a,b,K; };
+
+static minitip_THREAD int n,m,full;	/* variables, rows, the full set */
+static minitip_THREAD int ncol;	/* constraint columns */
+static minitip_THREAD const struct splx_column_t *col;
+static minitip_THREAD double *Binv;	/* basis inverse, row r and column s-1 at
+				   Binv[r*m+s-1] */
+static minitip_THREAD struct var_t *basis;	/* basic variables */
+static minitip_THREAD double *xB;	/* their values */
+static minitip_THREAD double *y;	/* simplex multipliers, y[0]=0 */
+static minitip_THREAD double *alpha;	/* the entering column in the basis */
+static minitip_THREAD double *rho;	/* a row of Binv indexed by subsets */
+static minitip_THREAD double *weight;	/* devex reference weights by var_key */
+static minitip_THREAD double *rhs;	/* the (perturbed) goal */
+static minitip_THREAD double *sgn;	/* sign of the artificial column of row s */
+static minitip_THREAD int *rbuf; static minitip_THREAD double *vbuf; /* column entries */
+
+/* order of the variables for Bland's rule; same as pricing order */
+static long long var_key(const struct var_t *v)
+{   switch(v->kind){
+  case V_ART:   return v->a-m-1;
+  case V_MONO:  return v->a;
+  case V_ELEM:  return n+((long long)(v->a*n+v->b)<<n)+v->K;
+    }
+    return n+((long long)(n*n)<<n)+2*v->a+(v->b<0);
+}
+
+/* the column of v as subsets in rbuf[], coefficients in vbuf[] */
+static int var_column(const struct var_t *v)
+{int k,i,j;
+    switch(v->kind){
+  case V_ART:
+        rbuf[0]=v->a; vbuf[0]=sgn[v->a]; return 1;
+  case V_MONO:
+        rbuf[0]=full; vbuf[0]=1.0;
+        rbuf[1]=full&~(1<<v->a); vbuf[1]=-1.0; return 2;
+  case V_ELEM:
+        i=1<<v->a; j=1<<v->b;
+        rbuf[0]=v->K|i; vbuf[0]=1.0;
+        rbuf[1]=v->K|j; vbuf[1]=1.0;
+        rbuf[2]=v->K|i|j; vbuf[2]=-1.0;
+        if(v->K==0) return 3;
+        rbuf[3]=v->K; vbuf[3]=-1.0; return 4;
+    }
+    for(k=0;k<col[v->a].n;k++){
+        rbuf[k]=col[v->a].row[k]; vbuf[k]=v->b*col[v->a].val[k];
+    }
+    return col[v->a].n;
+}
+
+/*----------------------------------------------------------------*/
+/* compute Binv from the basis by Gauss-Jordan elimination, and xB.
+   Returns 1 if the basis is singular. */
+static int refactor(const double goal[])
+{int r,s,k,p,len; double *B,t,big;
+    B=calloc((size_t)m*m,sizeof(double));
+    if(!B) return 1;
+    for(r=0;r<m;r++){ // B[s-1][r] is the basis column r
+        len=var_column(&basis[r]);
+        for(k=0;k<len;k++) B[(size_t)(rbuf[k]-1)*m+r]+=vbuf[k];
+    }
+    memset(Binv,0,(size_t)m*m*sizeof(double));
+    for(r=0;r<m;r++) Binv[(size_t)r*m+r]=1.0;
+    for(k=0;k<m;k++){ // eliminate column k
+        for(p=-1,big=0.0,r=k;r<m;r++) if(fabs(B[(size_t)r*m+k])>big){
+            big=fabs(B[(size_t)r*m+k]); p=r;
+        }
+        if(big<EPS_PIVOT){ free(B); return 1; }
+        if(p!=k) for(s=0;s<m;s++){
+            t=B[(size_t)p*m+s]; B[(size_t)p*m+s]=B[(size_t)k*m+s]; B[(size_t)k*m+s]=t;
+            t=Binv[(size_t)p*m+s]; Binv[(size_t)p*m+s]=Binv[(size_t)k*m+s]; Binv[(size_t)k*m+s]=t;
+        }
+        t=1.0/B[(size_t)k*m+k];
+        for(s=0;s<m;s++){ B[(size_t)k*m+s]*=t; Binv[(size_t)k*m+s]*=t; }
+        for(r=0;r<m;r++){
+            if(r==k || (t=B[(size_t)r*m+k])==0.0) continue;
+            for(s=0;s<m;s++){
+                B[(size_t)r*m+s]-=t*B[(size_t)k*m+s];
+                Binv[(size_t)r*m+s]-=t*Binv[(size_t)k*m+s];
+            }
+        }
+    }
+    free(B);
+    for(r=0;r<m;r++){
+        for(t=0.0,s=1;s<=m;s++) t+=Binv[(size_t)r*m+s-1]*goal[s];
+        xB[r]=t;
+    }
+    return 0;
+}
+
+/* simplex multipliers: the cost is 1 on artificial variables */
+static void compute_y(void)
+{int r,s; const double *row;
+    for(s=0;s<=m;s++) y[s]=0.0;
+    for(r=0;r<m;r++){
+        if(basis[r].kind!=V_ART) continue;
+        row=Binv+(size_t)r*m;
+        for(s=1;s<=m;s++) y[s]+=row[s-1];
+    }
+}
+
+/* go over the variables in pricing order; artificial variables come
+   first when art is set. Returns 0 when there are no more. */
+static int first_var(struct var_t *v, int art)
+{   v->kind = art ? V_ART : V_MONO; v->a=art ? 1 : 0; v->b=v->K=0;
+    return 1;
+}
+static int next_var(struct var_t *v)
+{int M;
+    switch(v->kind){
+  case V_ART:
+        if(v->a<m){ v->a++; return 1; }
+        v->kind=V_MONO; v->a=0; return 1;
+  case V_MONO:
+        if(v->a<n-1){ v->a++; return 1; }
+        v->kind=V_ELEM; v->a=0; v->b=1; v->K=0; return 1;
+  case V_ELEM:
+        M=full&~((1<<v->a)|(1<<v->b));
+        if((v->K=(v->K-M)&M)) return 1;
+        if(v->b<n-1){ v->b++; return 1; }
+        if(v->a<n-2){ v->a++; v->b=v->a+1; return 1; }
+        v->kind=V_CONSTR; v->a=-1; v->b=-1;
+        /* fall through */
+  default:
+        if(v->b>0 && col[v->a].free){ v->b=-1; return 1; }
+        if(v->a+1>=ncol) return 0;
+        v->a++; v->b=1; return 1;
+    }
+}
+/* inner product of the column of v and w[], w is indexed by subsets
+   and w[0]=0 */
+static double var_dot(const struct var_t *v, const double w[])
+{int i,j,k; double s;
+    switch(v->kind){
+  case V_ART:
+        return sgn[v->a]*w[v->a];
+  case V_MONO:
+        return w[full]-w[full&~(1<<v->a)];
+  case V_ELEM:
+        i=1<<v->a; j=1<<v->b;
+        return w[v->K|i]+w[v->K|j]-w[v->K|i|j]-w[v->K];
+    }
+    for(s=0.0,k=0;k<col[v->a].n;k++) s+=col[v->a].val[k]*w[col[v->a].row[k]];
+    return v->b*s;
+}
+
+/* find the entering variable by the reduced costs d_j=-y*A_j; return
+   0 if there is none. With bland set take the first candidate,
+   otherwise the one with largest d_j^2/weight_j. */
+static int pricing(int bland, struct var_t *enter)
+{int ok,found; double d,best; struct var_t v;
+    best=0.0; found=0;
+    for(ok=first_var(&v,0);ok;ok=next_var(&v)){
+        d=-var_dot(&v,y);
+        if(d>=-EPS_COST) continue;
+        if(bland){ *enter=v; return 1; }
+        d=d*d/weight[var_key(&v)];
+        if(d>best){ *enter=v; best=d; found=1; }
+    }
+    return found;
+}
+
+/* update the devex weights; pivot on row p with column q */
+static void devex(int p, const struct var_t *q)
+{int s,ok; double wq,a,t; struct var_t v;
+    rho[0]=0.0;
+    for(s=1;s<=m;s++) rho[s]=Binv[(size_t)p*m+s-1];
+    wq=weight[var_key(q)]/(alpha[p]*alpha[p]);
+    for(ok=first_var(&v,0);ok;ok=next_var(&v)){
+        a=var_dot(&v,rho);
+        if(a==0.0) continue;
+        t=a*a*wq;
+        if(t>weight[var_key(&v)]) weight[var_key(&v)]=t;
+    }
+    if(basis[p].kind!=V_ART) weight[var_key(&basis[p])]= wq>1.0 ? wq : 1.0;
+}
+
+/* the entering column in terms of the basis */
+static void ftran(const struct var_t *v)
+{int r,k,len; const double *row; double t;
+    len=var_column(v);
+    for(r=0;r<m;r++){
+        row=Binv+(size_t)r*m;
+        for(t=0.0,k=0;k<len;k++) t+=row[rbuf[k]-1]*vbuf[k];
+        alpha[r]=t;
+    }
+}
+
+/* pivot on row p */
+static void pivot(int p, const struct var_t *enter)
+{int r,s; double t,*prow,*row;
+    prow=Binv+(size_t)p*m;
+    t=1.0/alpha[p];
+    for(s=0;s<m;s++) prow[s]*=t;
+    for(r=0;r<m;r++){
+        if(r==p || alpha[r]==0.0) continue;
+        row=Binv+(size_t)r*m; t=alpha[r];
+        for(s=0;s<m;s++) row[s]-=t*prow[s];
+    }
+    basis[p]=*enter;
+}
+
+/* a dual simplex step: row p with negative xB[p] leaves the basis.
+   Returns 1 if no variable can enter. */
+static int dual_step(int p)
+{int s,ok,found; double a,d,ratio,best,bigalpha,step; struct var_t v,enter;
+    rho[0]=0.0;
+    for(s=1;s<=m;s++) rho[s]=Binv[(size_t)p*m+s-1];
+    found=0; best=bigalpha=0.0;
+    for(ok=first_var(&v,1);ok;ok=next_var(&v)){
+        a=var_dot(&v,rho);
+        if(a>=-EPS_PIVOT) continue;
+        d=(v.kind==V_ART ? 1.0 : 0.0)-var_dot(&v,y);
+        if(d<0.0) d=0.0;
+        ratio=d/(-a);
+        if(!found || ratio<best-1e-12 || (ratio<=best+1e-12 && -a>bigalpha)){
+            found=1; enter=v; best=ratio; bigalpha=-a;
+        }
+    }
+    if(!found) return 1;
+    ftran(&enter);
+    step=xB[p]/alpha[p];
+    for(s=0;s<m;s++) xB[s]-=step*alpha[s];
+    xB[p]=step;
+    pivot(p,&enter);
+    return 0;
+}
+
+/*----------------------------------------------------------------*/
+static void release(void)
+{   if(Binv){ free(Binv); Binv=NULL; }
+    if(basis){ free(basis); basis=NULL; }
+    if(xB){ free(xB); xB=NULL; }
+    if(y){ free(y); y=NULL; }
+    if(alpha){ free(alpha); alpha=NULL; }
+    if(rho){ free(rho); rho=NULL; }
+    if(rhs){ free(rhs); rhs=NULL; }
+    if(weight){ free(weight); weight=NULL; }
+    if(sgn){ free(sgn); sgn=NULL; }
+    if(rbuf){ free(rbuf); rbuf=NULL; }
+    if(vbuf){ free(vbuf); vbuf=NULL; }
+}
+
+int splx_solve(int varno, int ncols, const struct splx_column_t cols[],
+        const double goal[], int iterlimit, int timelimit)
+{int r,p,k,len,maxlen,degen,since,perturbed,result; unsigned seed;
+ double step,ratio,obj,gmax,tol;
+ struct var_t enter; time_t start;
+    splx_iterations=0;
+    if(varno<2 || varno>SPLX_MAX_VARNO) return SPLX_NOMEM;
+    n=varno; m=(1<<n)-1; full=m; ncol=ncols; col=cols;
+    for(maxlen=4,k=0;k<ncol;k++) if(col[k].n>maxlen) maxlen=col[k].n;
+    Binv=malloc((size_t)m*m*sizeof(double));
+    basis=malloc(m*sizeof(struct var_t));
+    xB=malloc(m*sizeof(double));
+    y=malloc((m+1)*sizeof(double));
+    alpha=malloc(m*sizeof(double));
+    rho=malloc((m+1)*sizeof(double));
+    rhs=malloc((m+1)*sizeof(double));
+    k=n+(n*n<<n)+2*ncol;
+    weight=malloc(k*sizeof(double));
+    if(weight) for(r=0;r<k;r++) weight[r]=1.0;
+    sgn=malloc((m+1)*sizeof(double));
+    rbuf=malloc(maxlen*sizeof(int));
+    vbuf=malloc(maxlen*sizeof(double));
+    if(!Binv || !basis || !xB || !y || !alpha || !rho || !rhs || !sgn
+       || !rbuf || !vbuf || !weight){
+        release(); return SPLX_NOMEM;
+    }
+    for(gmax=0.0,r=1;r<=m;r++) if(fabs(goal[r])>gmax) gmax=fabs(goal[r]);
+    tol=EPS_FEAS*(1.0+gmax);
+    /* the starting basis: artificial variables, B = diag(sgn) */
+    memset(Binv,0,(size_t)m*m*sizeof(double));
+    memcpy(rhs,goal,(m+1)*sizeof(double)); rhs[0]=0.0;
+    for(r=0;r<m;r++){
+        sgn[r+1] = goal[r+1]<0.0 ? -1.0 : 1.0;
+        basis[r].kind=V_ART; basis[r].a=r+1; basis[r].b=basis[r].K=0;
+        Binv[(size_t)r*m+r]=sgn[r+1];
+        xB[r]=fabs(goal[r+1]);
+    }
+    start=time(NULL); degen=0; since=0; perturbed=0; seed=12345u; result=-1;
+    while(result<0){
+        for(obj=0.0,r=0;r<m;r++) if(basis[r].kind==V_ART) obj+=xB[r];
+        compute_y();
+        if((perturbed!=1 && obj<=tol) || !pricing(degen>=DEGENERATE,&enter)){
+            if(since>0){ // check again with a fresh inverse
+                if(refactor(rhs)){ result=SPLX_FAIL; break; }
+                since=0; continue;
+            }
+            if(perturbed!=1){
+                result = obj<=tol ? SPLX_FEASIBLE : SPLX_INFEASIBLE;
+                break;
+            }
+            /* restore the goal and regain primal feasibility by the
+               dual simplex method; the basis stays dual feasible */
+            perturbed=2;
+            memcpy(rhs,goal,(m+1)*sizeof(double)); rhs[0]=0.0;
+            if(refactor(rhs)){ result=SPLX_FAIL; break; }
+            for(;;){
+                for(p=-1,step=-tol,r=0;r<m;r++) if(xB[r]<step){
+                    p=r; step=xB[r];
+                }
+                if(p<0) break;
+                if(splx_iterations>=iterlimit){ result=SPLX_ITLIM; break; }
+                if(time(NULL)-start>timelimit){ result=SPLX_TMLIM; break; }
+                compute_y();
+                if(dual_step(p)){ result=SPLX_FAIL; break; }
+                splx_iterations++; since++;
+            }
+            continue;
+        }
+        if(splx_iterations>=iterlimit){ result=SPLX_ITLIM; break; }
+        if(time(NULL)-start>timelimit){ result=SPLX_TMLIM; break; }
+        if(degen>=DEGENERATE && perturbed==0){
+            /* stalling: move the basic values away from zero by a small
+               pseudo-random amount, and change the goal accordingly */
+            perturbed=1; degen=0;
+            for(r=0;r<m;r++){
+                seed=seed*1103515245u+12345u;
+                step=PERTURB*(1.0+gmax)*(1.0+(double)((seed>>16)&0x7fff)/32768.0);
+                xB[r]+=step;
+                len=var_column(&basis[r]);
+                for(k=0;k<len;k++) rhs[rbuf[k]]+=step*vbuf[k];
+            }
+        }
+        ftran(&enter);
+        /* ratio test */
+        for(p=-1,step=0.0,r=0;r<m;r++){
+            if(alpha[r]<=EPS_PIVOT) continue;
+            ratio=(xB[r]>0.0 ? xB[r] : 0.0)/alpha[r];
+            if(p<0 || ratio<step-1e-12 ||
+               (ratio<=step+1e-12 && (degen>=DEGENERATE ?
+                   var_key(&basis[r])<var_key(&basis[p]) : alpha[r]>alpha[p]))){
+                p=r; step=ratio;
+            }
+        }
+        if(p<0){ result=SPLX_FAIL; break; } // phase 1 cannot be unbounded
+        for(r=0;r<m;r++) xB[r]-=step*alpha[r];
+        xB[p]=step;
+        devex(p,&enter);
+        pivot(p,&enter);
+        splx_iterations++; since++;
+        degen = step<=1e-12 ? degen+1 : 0;
+        if(since>=(m<100 ? 100 : m)){
+            if(refactor(rhs)){ result=SPLX_FAIL; break; }
+            since=0;
+        }
+    }
+    release();
+    return result;
+}
+
+/* EOF */
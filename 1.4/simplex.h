@@ -0,0 +1,64 @@
+/* simplex.h: built-in simplex method for the Shannon LP */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* Rows of the LP are the nonempty subsets 1 .. 2^n-1 of the n final
+* variables. The columns are the elemental Shannon inequalities
+*      (i,j|K) >= 0:  K+i, K+j, -K, -(K+i+j)   (K is a subset not
+*                     containing i and j, the empty set is left out)
+*      N-i <= N:      N, -(N-i)
+* which are never stored, and the constraint columns given explicitly.
+* The question is whether the goal g is a nonnegative combination of
+* the columns (free columns can have any sign).
+*
+* The phase 1 primal simplex method is used with one artificial
+* variable for each row, and with the basis inverse kept as a dense
+* matrix. Columns are priced in closed form from the bit patterns of
+* i, j and K with devex reference weights; the entering column in
+* terms of the basis needs only the (at most four) columns of the
+* inverse at its rows. When the method stalls, the basic values are
+* perturbed; at the end the goal is restored and primal feasibility is
+* regained by dual simplex steps. Bland's rule is the last resort.
+*
+* struct splx_column_t
+*    a constraint column: n entries, row[k] is a subset and val[k] is
+*    its coefficient; free is set if the column is free.
+* int splx_solve(int n, int ncols, const struct splx_column_t col[],
+*        const double goal[], int iterlimit, int timelimit)
+*    goal[s] is the coefficient of subset s, goal[0] is not used.
+*    timelimit is in seconds. Returns one of the SPLX_ codes below.
+* int splx_iterations
+*    number of simplex iterations in the last call.
+*/
+
+#define SPLX_MAX_VARNO	11	/* the inverse has 4^n entries */
+
+#define SPLX_FEASIBLE	0	/* the goal follows */
+#define SPLX_INFEASIBLE	1	/* the goal does not follow */
+#define SPLX_ITLIM	2	/* iteration limit exceeded */
+#define SPLX_TMLIM	3	/* time limit exceeded */
+#define SPLX_NOMEM	4	/* out of memory, or too many variables */
+#define SPLX_FAIL	5	/* numerical trouble */
+
+struct splx_column_t {
+    int free;			/* free column */
+    int n;			/* number of entries */
+    const int *row;		/* subsets */
+    const double *val;		/* coefficients */
+};
+
+int splx_solve(int n, int ncols, const struct splx_column_t col[],
+        const double goal[], int iterlimit, int timelimit);
+extern minitip_THREAD int splx_iterations;
+
+/* EOF */
@@ -0,0 +1,149 @@
+/* symmetry.c: variable permutations fixing the problem */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+#include "symmetry.h"
+
+/*----------------------------------------------------------------*/
+/* canonical form of a column: terms sorted by subset and scaled so
+   that the first coefficient is +1 or -1 (+1 for free columns) */
+struct canon_t {
+    int free, n;
+    int *set;
+    double *coeff;
+};
+
+/* image of the subset s under the permutation pi */
+static int map_set(int s, const int pi[])
+{int i,r;
+    for(r=0,i=0;s;i++,s>>=1) if(s&1) r|=1<<pi[i];
+    return r;
+}
+
+/* the canonical form of column c mapped by pi; out has enough space */
+static void canonize(const struct sym_column_t *c, const int pi[],
+        struct canon_t *out)
+{int i,j,ts; double tc,scale;
+    out->free=c->free; out->n=c->n;
+    for(i=0;i<c->n;i++){ /* insertion sort by subset */
+        ts=map_set(c->set[i],pi); tc=c->coeff[i];
+        for(j=i;j>0 && out->set[j-1]>ts;j--){
+            out->set[j]=out->set[j-1]; out->coeff[j]=out->coeff[j-1];
+        }
+        out->set[j]=ts; out->coeff[j]=tc;
+    }
+    if(c->n==0) return;
+    scale = c->free ? out->coeff[0] : fabs(out->coeff[0]);
+    for(i=0;i<c->n;i++) out->coeff[i] /= scale;
+}
+
+static int same_canon(const struct canon_t *a, const struct canon_t *b)
+{int i;
+    if(a->free!=b->free || a->n!=b->n) return 0;
+    for(i=0;i<a->n;i++){
+        if(a->set[i]!=b->set[i]) return 0;
+        if(fabs(a->coeff[i]-b->coeff[i])>1e-9*(1.0+fabs(a->coeff[i])))
+            return 0;
+    }
+    return 1;
+}
+
+/* check whether pi is a symmetry; canon[] are the canonical forms of
+   the columns, tmp is a work space */
+static int is_symmetry(int var_no, const double goal[], int ncols,
+        const struct sym_column_t col[], const struct canon_t canon[],
+        struct canon_t *tmp, const int pi[])
+{int s,j,k;
+    for(s=1;s<(1<<var_no);s++){
+        if(goal[map_set(s,pi)]!=goal[s]) return 0;
+    }
+    for(j=0;j<ncols;j++){
+        canonize(&col[j],pi,tmp);
+        for(k=0;k<ncols && !same_canon(tmp,&canon[k]);k++);
+        if(k==ncols) return 0;
+    }
+    return 1;
+}
+
+/*----------------------------------------------------------------*/
+/* union-find on subsets */
+static int find(int *parent, int s)
+{int r,t;
+    for(r=s;parent[r]!=r;r=parent[r]);
+    while(parent[s]!=r){ t=parent[s]; parent[s]=r; s=t; }
+    return r;
+}
+static void join(int var_no, int *parent, const int pi[])
+{int s,a,b;
+    for(s=1;s<(1<<var_no);s++){
+        a=find(parent,s); b=find(parent,map_set(s,pi));
+        if(a<b) parent[b]=a; else if(b<a) parent[a]=b;
+    }
+}
+
+int symmetry_orbits(int var_no, const double goal[], int ncols,
+        const struct sym_column_t col[], int orbit[])
+{int i,j,k,l,m,maxn,found,total,ok; int pi[32],id[32],trans[32][32];
+ struct canon_t *canon,tmp; int *parent,*ibuf; double *dbuf;
+    total=(1<<var_no)-1;
+    for(maxn=0,i=0,j=0;j<ncols;j++){
+        i += col[j].n; if(col[j].n>maxn) maxn=col[j].n;
+    }
+    canon=malloc((ncols+1)*sizeof(struct canon_t));
+    parent=malloc((total+1)*sizeof(int));
+    ibuf=malloc((i+maxn+1)*sizeof(int));
+    dbuf=malloc((i+maxn+1)*sizeof(double));
+    ok = canon && parent && ibuf && dbuf;
+    if(ok){
+        for(i=0;i<var_no;i++) id[i]=i;
+        for(i=0,j=0;j<ncols;j++){
+            canon[j].set=ibuf+i; canon[j].coeff=dbuf+i; i+=col[j].n;
+            canonize(&col[j],id,&canon[j]);
+        }
+        tmp.set=ibuf+i; tmp.coeff=dbuf+i;
+        for(i=0;i<=total;i++) parent[i]=i;
+        found=0;
+        /* transpositions */
+        for(i=0;i<var_no;i++) for(j=i+1;j<var_no;j++){
+            for(k=0;k<var_no;k++) pi[k]=k;
+            pi[i]=j; pi[j]=i;
+            trans[i][j]=is_symmetry(var_no,goal,ncols,col,canon,&tmp,pi);
+            if(trans[i][j]){ join(var_no,parent,pi); found=1; }
+        }
+        /* products of two disjoint transpositions (i j)(k l), i<k */
+        for(i=0;i<var_no;i++) for(j=i+1;j<var_no;j++)
+        for(k=i+1;k<var_no;k++) for(l=k+1;l<var_no;l++){
+            if(k==j || l==j) continue;
+            if(trans[i][j] && trans[k][l]) continue; /* generated */
+            for(m=0;m<var_no;m++) pi[m]=m;
+            pi[i]=j; pi[j]=i; pi[k]=l; pi[l]=k;
+            if(is_symmetry(var_no,goal,ncols,col,canon,&tmp,pi)){
+                join(var_no,parent,pi); found=1;
+            }
+        }
+        /* number the orbits */
+        for(i=1,k=0;i<=total;i++){
+            j=find(parent,i);
+            if(j==i){ k++; orbit[i]=k; } else orbit[i]=orbit[j];
+        }
+        if(!found) k=total;
+    }
+    if(canon) free(canon);
+    if(parent) free(parent);
+    if(ibuf) free(ibuf);
+    if(dbuf) free(dbuf);
+    return ok ? k : -1;
+}
+
+/* EOF */
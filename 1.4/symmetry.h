@@ -0,0 +1,49 @@
+/* symmetry.h: variable permutations fixing the problem */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* Subsets of the var_no final variables are bitmaps 1 .. 2^var_no-1.
+* A permutation of the variables is a symmetry if it fixes the goal,
+* and maps each constraint column to a positive multiple of another
+* constraint column (any nonzero multiple for free columns).
+*
+* Symmetries are searched among transpositions and products of two
+* disjoint transpositions of the variables; the group G they generate
+* fixes the problem as well. If x solves the LP, then so does its
+* average over G, thus it suffices to solve the LP where each column
+* is replaced by its average over G, and rows in the same G-orbit are
+* summed up. The average of a column at a subset is its average over
+* the orbit of that subset.
+*
+* struct sym_column_t
+*    a constraint column: n terms, set[i] is a subset, coeff[i] is its
+*    coefficient; free is set for free (=0) columns.
+* int symmetry_orbits(int var_no, const double goal[], int ncols,
+*        const struct sym_column_t col[], int orbit[])
+*    goal[s] is the coefficient of subset s (goal[0] is not used).
+*    Fills orbit[1..2^var_no-1] with the orbit number of the subset,
+*    numbered from 1, and returns the number of orbits; this is
+*    2^var_no-1 if no symmetry was found. Returns -1 if out of memory.
+*/
+
+struct sym_column_t {
+    int free;			/* free column */
+    int n;			/* number of terms */
+    const int *set;		/* subsets */
+    const double *coeff;	/* coefficients */
+};
+
+int symmetry_orbits(int var_no, const double goal[], int ncols,
+        const struct sym_column_t col[], int orbit[]);
+
+/* EOF */
@@ -0,0 +1,235 @@
+/* verify.c: exact verification of the LP verdict */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "minitip.h"
+#include "verify.h"
+
+/*----------------------------------------------------------------*/
+/* rational numbers with 64 bit numerator and denominator. The
+   denominator is positive, and gcd(p,q)=1. On overflow rat_overflow
+   is set, and the result is meaningless. */
+typedef struct { long long p,q; } rat_t;
+static minitip_THREAD int rat_overflow;
+
+#define MAX_DENOMINATOR	(1LL<<24) /* when rounding a double */
+
+static long long gcd(long long a, long long b)
+{long long t;
+    if(a<0) a=-a;
+    if(b<0) b=-b;
+    while(b){ t=a%b; a=b; b=t; }
+    return a;
+}
+static rat_t rat_add(rat_t a, rat_t b)
+{rat_t r; long long g,x,y;
+    if(a.p==0) return b;
+    if(b.p==0) return a;
+    g=gcd(a.q,b.q);
+    if(__builtin_mul_overflow(a.p,b.q/g,&x) ||
+       __builtin_mul_overflow(b.p,a.q/g,&y) ||
+       __builtin_add_overflow(x,y,&r.p) ||
+       __builtin_mul_overflow(a.q/g,b.q,&r.q)){
+        rat_overflow=1; r.p=0; r.q=1; return r;
+    }
+    if(r.p==0){ r.q=1; return r; }
+    g=gcd(r.p,r.q); r.p/=g; r.q/=g;
+    return r;
+}
+static rat_t rat_mul(rat_t a, rat_t b)
+{rat_t r; long long g1,g2;
+    if(a.p==0 || b.p==0){ r.p=0; r.q=1; return r; }
+    g1=gcd(a.p,b.q); g2=gcd(b.p,a.q);
+    if(__builtin_mul_overflow(a.p/g1,b.p/g2,&r.p) ||
+       __builtin_mul_overflow(a.q/g2,b.q/g1,&r.q)){
+        rat_overflow=1; r.p=0; r.q=1;
+    }
+    return r;
+}
+/* find p/q close to v using continued fractions. Return 0 if there is
+   no such fraction with small denominator */
+static int rationalize(double v, rat_t *r)
+{double x,f,eps; long long a,p0,q0,p1,q1,p2,q2; int k;
+    x=fabs(v); eps=1e-9*(x>1.0 ? x : 1.0);
+    r->p=0; r->q=1;
+    if(x<=eps) return 1;
+    if(x>1e12) return 0;
+    p0=0; q0=1; p1=1; q1=0; f=x;
+    for(k=0;k<64;k++){
+        a=(long long)floor(f);
+        if(__builtin_mul_overflow(a,p1,&p2) ||
+           __builtin_add_overflow(p2,p0,&p2)) return 0;
+        q2=a*q1+q0; /* q1<=MAX_DENOMINATOR, a<=1/eps */
+        if(q2>MAX_DENOMINATOR) return 0;
+        p0=p1; q0=q1; p1=p2; q1=q2;
+        if(fabs(x-(double)p1/(double)q1)<=eps){
+            r->p = v<0.0 ? -p1 : p1; r->q=q1;
+            return 1;
+        }
+        f -= (double)a;
+        if(f<1e-15) break;
+        f=1.0/f;
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------*/
+/* writing certificates */
+static void write_rat(FILE *f, rat_t r)
+{   if(r.q==1) fprintf(f,"%lld",r.p);
+    else fprintf(f,"%lld/%lld",r.p,r.q);
+}
+/* write " c*s" for the entries of column j */
+static void write_column(glp_prob *P, int j, const struct cert_t *cert,
+     int *ind, double *val)
+{int k,len; rat_t a;
+    len=glp_get_mat_col(P,j,ind,val);
+    for(k=1;k<=len;k++){
+        rationalize(val[k],&a);
+        fprintf(cert->f," "); write_rat(cert->f,a);
+        fprintf(cert->f,"*%d",cert->rowset[ind[k]]);
+    }
+}
+void cert_goal(glp_prob *P, const struct cert_t *cert)
+{int i,m; rat_t a;
+    m=glp_get_num_rows(P);
+    fprintf(cert->f,"goal");
+    for(i=1;i<=m;i++){
+        rationalize(glp_get_row_lb(P,i),&a);
+        if(a.p==0) continue;
+        fprintf(cert->f," "); write_rat(cert->f,a);
+        fprintf(cert->f,"*%d",cert->rowset[i]);
+    }
+    fprintf(cert->f,"\n");
+}
+
+/*----------------------------------------------------------------*/
+/* h[1..m] are rationals; check that h*A_j>=0 for >=0 columns, and
+   h*A_j=0 for free columns, and h*g<0. Return 1 if all holds. */
+static int check_entropy_vector(glp_prob *P, const rat_t *h, int *ind, double *val)
+{int m,n,i,j,k,len; rat_t s,a;
+    m=glp_get_num_rows(P); n=glp_get_num_cols(P);
+    for(j=1;j<=n;j++){
+        len=glp_get_mat_col(P,j,ind,val);
+        s.p=0; s.q=1;
+        for(k=1;k<=len;k++){
+            if(!rationalize(val[k],&a)) return 0;
+            s=rat_add(s,rat_mul(a,h[ind[k]]));
+        }
+        if(rat_overflow) return 0;
+        if(glp_get_col_type(P,j)==GLP_FR ? s.p!=0 : s.p<0) return 0;
+    }
+    s.p=0; s.q=1;
+    for(i=1;i<=m;i++){
+        if(!rationalize(glp_get_row_lb(P,i),&a)) return 0;
+        s=rat_add(s,rat_mul(a,h[i]));
+    }
+    return !rat_overflow && s.p<0;
+}
+
+int verify_feasible(glp_prob *P, const double xval[], const struct cert_t *cert)
+{int m,n,i,j,k,len,ok; int *ind; double *val; rat_t *sum,*x,a;
+    m=glp_get_num_rows(P); n=glp_get_num_cols(P);
+    sum=malloc((m+1)*sizeof(rat_t));
+    x=malloc((n+1)*sizeof(rat_t));
+    ind=malloc((m+1)*sizeof(int));
+    val=malloc((m+1)*sizeof(double));
+    ok = xval && sum && x && ind && val; rat_overflow=0;
+    for(i=0;ok && i<=m;i++){ sum[i].p=0; sum[i].q=1; }
+    for(j=1;ok && j<=n;j++){
+        if(!rationalize(xval[j],&x[j])){ ok=0; break; }
+        if(x[j].p==0) continue;
+        if(x[j].p<0 && glp_get_col_type(P,j)!=GLP_FR){ ok=0; break; }
+        len=glp_get_mat_col(P,j,ind,val);
+        for(k=1;k<=len;k++){
+            if(!rationalize(val[k],&a)){ ok=0; break; }
+            sum[ind[k]]=rat_add(sum[ind[k]],rat_mul(a,x[j]));
+        }
+    }
+    for(i=1;ok && i<=m;i++){
+        if(!rationalize(glp_get_row_lb(P,i),&a) || rat_overflow ||
+           a.p!=sum[i].p || a.q!=sum[i].q) ok=0;
+    }
+    if(ok && cert){
+        fprintf(cert->f,"TRUE\n");
+        for(j=1;j<=n;j++) if(x[j].p!=0){
+            if(cert->coltag[j]) fprintf(cert->f,"col C%d ",cert->coltag[j]);
+            else fprintf(cert->f,"col S ");
+            write_rat(cert->f,x[j]); fprintf(cert->f," :");
+            write_column(P,j,cert,ind,val);
+            fprintf(cert->f,"\n");
+        }
+    }
+    if(sum) free(sum);
+    if(x) free(x);
+    if(ind) free(ind);
+    if(val) free(val);
+    return ok;
+}
+
+int verify_infeasible(glp_prob *P, const glp_smcp *parm,
+                      const struct cert_t *cert)
+{int m,i,ok,base; int *ind; double *val,*hd,hmax; rat_t *h;
+ glp_prob *Q; glp_smcp parm1;
+    m=glp_get_num_rows(P);
+    h=malloc((m+1)*sizeof(rat_t));
+    hd=malloc((m+1)*sizeof(double));
+    ind=malloc((m+1)*sizeof(int));
+    val=malloc((m+1)*sizeof(double));
+    ok = h && hd && ind && val; rat_overflow=0;
+    if(ok){ /* phase 1 problem */
+        Q=glp_create_prob();
+        glp_copy_prob(Q,P,GLP_OFF);
+        glp_set_obj_dir(Q,GLP_MIN);
+        base=glp_add_cols(Q,2*m);
+        for(i=1;i<=m;i++){
+            ind[1]=i; val[1]=1.0;
+            glp_set_mat_col(Q,base+2*i-2,1,ind,val);
+            val[1]=-1.0;
+            glp_set_mat_col(Q,base+2*i-1,1,ind,val);
+            glp_set_col_bnds(Q,base+2*i-2,GLP_LO,0.0,0.0);
+            glp_set_col_bnds(Q,base+2*i-1,GLP_LO,0.0,0.0);
+            glp_set_obj_coef(Q,base+2*i-2,1.0);
+            glp_set_obj_coef(Q,base+2*i-1,1.0);
+        }
+        parm1=*parm; parm1.meth=GLP_PRIMAL; parm1.presolve=GLP_ON;
+        if(glp_simplex(Q,&parm1)!=0 || glp_get_status(Q)!=GLP_OPT) ok=0;
+        hmax=0.0;
+        for(i=1;ok && i<=m;i++){
+            hd[i]=-glp_get_row_dual(Q,i);
+            if(fabs(hd[i])>hmax) hmax=fabs(hd[i]);
+        }
+        glp_delete_prob(Q);
+        if(hmax<1e-9) ok=0;
+        for(i=1;ok && i<=m;i++){ /* normalize and round */
+            if(!rationalize(hd[i]/hmax,&h[i])) ok=0;
+        }
+    }
+    if(ok) ok=check_entropy_vector(P,h,ind,val);
+    if(ok && cert){
+        fprintf(cert->f,"FALSE\n");
+        for(i=1;i<=m;i++) if(h[i].p!=0){
+            fprintf(cert->f,"h %d ",cert->rowset[i]);
+            write_rat(cert->f,h[i]); fprintf(cert->f,"\n");
+        }
+    }
+    if(h) free(h);
+    if(hd) free(hd);
+    if(ind) free(ind);
+    if(val) free(val);
+    return ok;
+}
+
+/* EOF */
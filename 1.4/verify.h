@@ -0,0 +1,67 @@
+/* verify.h: exact verification of the LP verdict */
+
+/***********************************************************************
+* This code is part of MINITIP (a MINimal Information Theoretic Prover)
+*
+* Copyright (2016-2024) Laszlo Csirmaz, github.com/lcsirmaz/minitip
+*
+* This program is free, open-source software. You may redistribute it
+* and/or modify under the terms of the GNU General Public License (GPL).
+*
+* There is ABSOLUTELY NO WARRANTY, use at your own risk.
+*************************************************************************/
+
+/***********************************************************************
+* The LP has one row for each subset of the variables, and one column
+* for each Shannon inequality and constraint. Rows are fixed to the
+* coefficients of the goal g; columns are either >=0 or free.
+*
+* int verify_feasible(glp_prob *P, const double xval[],
+*        const struct cert_t *cert)
+*    P has been solved and found feasible, xval[1..n] are the column
+*    values. Round them to rationals and check A*x=g and x>=0 in exact
+*    arithmetic.
+*    Return 1 if this is a proof, 0 otherwise.
+* int verify_infeasible(glp_prob *P, const glp_smcp *parm,
+*        const struct cert_t *cert)
+*    P has been found infeasible. Solve the phase 1 problem
+*         min sum(s+ + s-)  A*x + s+ - s- = g
+*    and take h=-y where y is its row dual. Round h to rationals and
+*    check that h*A_j>=0 for >=0 columns, h*A_j=0 for free columns,
+*    and h*g<0 in exact arithmetic. h is an entropy vector which
+*    satisfies all columns but violates the goal.
+*    Return 1 if this is a proof, 0 otherwise.
+*
+* Certificates
+*    When cert is not NULL, a proof is written to cert->f. Rows are
+*    written as the subset cert->rowset[i] (a bitmap), and column j
+*    is a Shannon inequality if cert->coltag[j]==0, and the k-th
+*    constraint if cert->coltag[j]==k>0. Lines are
+*      goal <c*s> ...        the goal as coefficient*subset list
+*      TRUE                  followed by lines
+*      col <tag> <x> : <c*s> ...
+*                            the column, tag is S or C<k>, multiplied
+*                            by x; these columns add up to the goal
+*      FALSE                 followed by lines
+*      h <s> <value>         entropy of subset s, zero if missing;
+*                            all columns are >=0 (or =0 if free) on h,
+*                            and the goal is negative
+*    Numbers are integers or fractions p/q.
+* void cert_goal(glp_prob *P, const struct cert_t *cert)
+*    write the goal line.
+*/
+
+#include "glpk.h"
+
+struct cert_t {
+    FILE *f;			/* where to write the certificate */
+    const int *rowset;		/* rowset[i] is the subset of row i */
+    const int *coltag;		/* column tags */
+};
+
+int verify_feasible(glp_prob *P, const double xval[], const struct cert_t *cert);
+int verify_infeasible(glp_prob *P, const glp_smcp *parm,
+                      const struct cert_t *cert);
+void cert_goal(glp_prob *P, const struct cert_t *cert);
+
+/* EOF */